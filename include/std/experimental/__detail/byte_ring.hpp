@@ -0,0 +1,181 @@
+// Copyright (c) 2023 Gor Nishanov
+// Licensed under MIT license. See LICENSE.txt for details.
+
+#ifndef _STD_EXPERIMENTAL_CONQUEUE_BYTE_RING
+#define _STD_EXPERIMENTAL_CONQUEUE_BYTE_RING
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+namespace std::experimental::__detail {
+
+// A ring of variable size records, laid out contiguously in a single buffer.
+// Every record starts with a header and is padded to a multiple of the
+// alignment, so that payloads are always suitably aligned for the common
+// scalar types. A record that does not fit before the end of the buffer is
+// preceded by a padding record taking up the rest of it, so that payloads are
+// never split. Records are reserved and committed in any order by any number
+// of writers and are read in reservation order. The space of a record is
+// reclaimed once it and all the records before it were released.
+//
+// The ring does no synchronization of its own.
+class byte_ring {
+public:
+  static constexpr size_t alignment = 8;
+
+private:
+  struct header {
+    uint32_t size;   // bytes taken in the ring, low bits hold the state
+    uint32_t length; // of the payload
+  };
+  static_assert(sizeof(header) == alignment);
+
+  enum state : uint32_t { reserved, committed, reading, released, padding };
+  static constexpr uint32_t state_mask = alignment - 1;
+
+  static size_t align_up(size_t n) noexcept {
+    return (n + alignment - 1) & ~(alignment - 1);
+  }
+
+  header* header_at(uint64_t pos) const noexcept {
+    return reinterpret_cast<header*>(buffer_.get() + pos % capacity_);
+  }
+  static header* header_of(const std::byte* payload) noexcept {
+    return reinterpret_cast<header*>(const_cast<std::byte*>(payload) -
+                                     sizeof(header));
+  }
+
+  static size_t size_of(const header* h) noexcept {
+    return h->size & ~state_mask;
+  }
+  static state state_of(const header* h) noexcept {
+    return static_cast<state>(h->size & state_mask);
+  }
+  static void set_state(header* h, state s) noexcept {
+    h->size = (h->size & ~state_mask) | s;
+  }
+
+  std::unique_ptr<std::byte[]> buffer_;
+  size_t capacity_;
+  // Positions grow monotonically and are reset to zero whenever the ring is
+  // empty. free_ <= read_ <= write_.
+  uint64_t free_{};  // start of the oldest record not yet released
+  uint64_t read_{};  // start of the oldest record not yet read
+  uint64_t write_{}; // end of the newest reserved record
+
+public:
+  // The capacity is rounded down to a multiple of the alignment.
+  explicit byte_ring(size_t capacity)
+      : buffer_(new std::byte[capacity & ~(alignment - 1)]),
+        capacity_(capacity & ~(alignment - 1)) {
+    assert(capacity_ >= 2 * sizeof(header) && capacity_ <= UINT32_MAX);
+  }
+
+  size_t capacity() const noexcept { return capacity_; }
+  size_t max_record_size() const noexcept {
+    return capacity_ - sizeof(header);
+  }
+
+  // Bytes taken by records that were not released yet, including headers
+  // and padding.
+  size_t used() const noexcept { return write_ - free_; }
+  bool empty() const noexcept { return write_ == free_; }
+
+  // Reserves a record with room for n bytes of payload. Returns an empty
+  // span with a null data() if there is not enough free space.
+  std::span<std::byte> try_reserve(size_t n) noexcept {
+    assert(n <= max_record_size());
+    size_t size = align_up(sizeof(header) + n);
+    size_t offset = write_ % capacity_;
+    size_t tail_room = capacity_ - offset;
+    size_t needed = size <= tail_room ? size : tail_room + size;
+    if (capacity_ - used() < needed)
+      return {};
+
+    if (size > tail_room) {
+      auto* pad = header_at(write_);
+      pad->size = static_cast<uint32_t>(tail_room) | padding;
+      pad->length = 0;
+      write_ += tail_room;
+    }
+
+    auto* h = header_at(write_);
+    h->size = static_cast<uint32_t>(size) | reserved;
+    h->length = 0;
+    write_ += size;
+    return {reinterpret_cast<std::byte*>(h + 1), n};
+  }
+
+  // Makes a reserved record available to readers. The record may be a
+  // prefix of the span returned by try_reserve, in which case only that
+  // many bytes are handed to the reader.
+  void commit(std::span<std::byte> record) noexcept {
+    auto* h = header_of(record.data());
+    assert(state_of(h) == reserved);
+    assert(sizeof(header) + record.size() <= size_of(h));
+    h->length = static_cast<uint32_t>(record.size());
+    set_state(h, committed);
+  }
+
+  // True if the oldest unread record is committed.
+  bool readable() noexcept {
+    skip_padding();
+    return read_ != write_ && state_of(header_at(read_)) == committed;
+  }
+
+  // Returns the oldest unread record, provided that it is committed, and
+  // marks it as being read. Returns an empty span with a null data()
+  // otherwise.
+  std::span<std::byte> try_read() noexcept {
+    if (!readable())
+      return {};
+
+    auto* h = header_at(read_);
+    set_state(h, reading);
+    read_ += size_of(h);
+    return {reinterpret_cast<std::byte*>(h + 1), h->length};
+  }
+
+  // Releases a record returned by try_read. Returns true if space was
+  // reclaimed, which only happens once all the older records were released.
+  bool release(std::span<const std::byte> record) noexcept {
+    auto* h = header_of(record.data());
+    assert(state_of(h) == reading);
+    set_state(h, released);
+
+    uint64_t old_free = free_;
+    while (free_ != read_) {
+      auto* oldest = header_at(free_);
+      auto s = state_of(oldest);
+      if (s != released && s != padding)
+        break;
+      free_ += size_of(oldest);
+    }
+
+    bool reclaimed = free_ != old_free;
+
+    // Starting over from the beginning of the buffer lets any record up to
+    // max_record_size fit without padding.
+    if (empty())
+      free_ = read_ = write_ = 0;
+
+    return reclaimed;
+  }
+
+private:
+  void skip_padding() noexcept {
+    while (read_ != write_) {
+      auto* h = header_at(read_);
+      if (state_of(h) != padding)
+        break;
+      read_ += size_of(h);
+    }
+  }
+};
+
+} // namespace std::experimental::__detail
+
+#endif // _STD_EXPERIMENTAL_CONQUEUE_BYTE_RING
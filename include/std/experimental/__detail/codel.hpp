@@ -0,0 +1,133 @@
+// Copyright (c) 2023 Gor Nishanov
+// Licensed under MIT license. See LICENSE.txt for details.
+
+#ifndef _STD_EXPERIMENTAL_CONQUEUE_CODEL
+#define _STD_EXPERIMENTAL_CONQUEUE_CODEL
+
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+namespace std::experimental::__detail {
+
+// A histogram of sojourn times with power of two buckets. Bucket i counts
+// durations in [2^(i-1), 2^i) nanoseconds, so percentiles are reported as the
+// upper bound of the bucket they fall into (i.e. within a factor of two).
+class sojourn_histogram {
+  using duration = chrono::nanoseconds;
+  static constexpr size_t bucket_count = 64;
+
+  array<uint64_t, bucket_count> buckets_{};
+  uint64_t count_{};
+  duration max_{};
+
+public:
+  void record(duration d) noexcept {
+    uint64_t ns = d.count() > 0 ? static_cast<uint64_t>(d.count()) : 0;
+    size_t bucket = std::min<size_t>(std::bit_width(ns), bucket_count - 1);
+    ++buckets_[bucket];
+    ++count_;
+    if (d > max_)
+      max_ = d;
+  }
+
+  uint64_t count() const noexcept { return count_; }
+  duration max() const noexcept { return max_; }
+
+  // Returns the upper bound of the bucket containing the p-th percentile,
+  // 0 < p <= 1, clamped to the largest duration seen so far.
+  duration percentile(double p) const noexcept {
+    if (count_ == 0)
+      return {};
+
+    auto rank = static_cast<uint64_t>(std::ceil(p * count_));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < bucket_count; ++i) {
+      seen += buckets_[i];
+      if (seen >= rank && buckets_[i] != 0)
+        return std::min(duration(i == 0 ? 0 : (uint64_t(1) << i) - 1), max_);
+    }
+    return max_;
+  }
+};
+
+// The controlled delay (CoDel) dropping policy of RFC 8289, evaluated one
+// element at a time as elements leave the queue. Once the sojourn time has
+// stayed above `target` for at least `interval`, the controller enters the
+// dropping state and drops elements at a rate that increases with the square
+// root of the number of drops, until the sojourn time falls below target.
+class codel_controller {
+public:
+  using clock = chrono::steady_clock;
+  using duration = chrono::nanoseconds;
+
+  codel_controller(duration target, duration interval) noexcept
+      : target_(target), interval_(interval) {}
+
+  // Decides the fate of an element that spent `sojourn` in the queue. `last`
+  // indicates that this is the only element left, which is never dropped.
+  bool should_drop(clock::time_point now, duration sojourn,
+                   bool last) noexcept {
+    bool ok_to_drop = compute_ok_to_drop(now, sojourn, last);
+
+    if (dropping_) {
+      if (!ok_to_drop) {
+        dropping_ = false;
+        return false;
+      }
+      if (now < drop_next_)
+        return false;
+
+      ++count_;
+      drop_next_ = control_law(drop_next_);
+      return true;
+    }
+
+    if (!ok_to_drop)
+      return false;
+
+    // Enter the dropping state. If we were dropping recently, resume at the
+    // rate we left off rather than starting all over again.
+    dropping_ = true;
+    uint32_t delta = count_ - last_count_;
+    count_ = (delta > 1 && now - drop_next_ < 16 * interval_) ? delta : 1;
+    last_count_ = count_;
+    drop_next_ = control_law(now);
+    return true;
+  }
+
+  bool dropping() const noexcept { return dropping_; }
+
+private:
+  bool compute_ok_to_drop(clock::time_point now, duration sojourn,
+                          bool last) noexcept {
+    if (sojourn < target_ || last) {
+      first_above_time_ = {};
+      return false;
+    }
+    if (first_above_time_ == clock::time_point{}) {
+      first_above_time_ = now + interval_;
+      return false;
+    }
+    return now >= first_above_time_;
+  }
+
+  clock::time_point control_law(clock::time_point t) const noexcept {
+    return t + chrono::duration_cast<duration>(interval_ /
+                                               std::sqrt(double(count_)));
+  }
+
+  duration target_;
+  duration interval_;
+  clock::time_point first_above_time_{};
+  clock::time_point drop_next_{};
+  uint32_t count_{};
+  uint32_t last_count_{};
+  bool dropping_{};
+};
+
+} // namespace std::experimental::__detail
+
+#endif // _STD_EXPERIMENTAL_CONQUEUE_CODEL
@@ -0,0 +1,34 @@
+// Copyright (c) 2023 Gor Nishanov
+// Licensed under MIT license. See LICENSE.txt for details.
+
+#ifndef _STD_EXPERIMENTAL_CONQUEUE_EVENTFD
+#define _STD_EXPERIMENTAL_CONQUEUE_EVENTFD
+
+#if __has_include(<sys/eventfd.h>)
+#define STDEX_CONQUEUE_HAS_EVENTFD 1
+
+namespace std::experimental::__detail {
+
+// A non-blocking Linux eventfd, used to let epoll/io_uring reactors wait for
+// a queue to become ready.
+class eventfd {
+  int fd_;
+
+public:
+  eventfd(); // throws system_error
+  ~eventfd();
+
+  eventfd(const eventfd&) = delete;
+  eventfd& operator=(const eventfd&) = delete;
+
+  int native_handle() const noexcept { return fd_; }
+
+  // Makes the descriptor readable until the reactor reads from it.
+  void signal() noexcept;
+};
+
+} // namespace std::experimental::__detail
+
+#endif // __has_include(<sys/eventfd.h>)
+
+#endif // _STD_EXPERIMENTAL_CONQUEUE_EVENTFD
@@ -0,0 +1,181 @@
+// Copyright (c) 2023 Gor Nishanov
+// Licensed under MIT license. See LICENSE.txt for details.
+
+#ifndef _STD_EXPERIMENTAL_CONQUEUE_FLAT_COMBINING
+#define _STD_EXPERIMENTAL_CONQUEUE_FLAT_COMBINING
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <std/experimental/__detail/spinlock.hpp>
+
+namespace std::experimental::__detail {
+
+// Base of the requests published for flat combining. The publisher spins on
+// `status` while the combiner executes the request on its behalf.
+struct combining_request {
+  enum : uint32_t {
+    pending,
+    done,
+    // The request could not complete without blocking. The publisher has to
+    // take the regular path.
+    declined,
+  };
+
+  std::atomic<uint32_t> status{pending};
+
+  uint32_t load_status() const noexcept {
+    return status.load(std::memory_order_acquire);
+  }
+  void finish(uint32_t result) noexcept {
+    status.store(result, std::memory_order_release);
+  }
+};
+
+// The publication records of flat combining. Each thread publishes its
+// requests in a record of its own, on a cache line of its own, registered
+// the first time the thread publishes. The thread holding the lock collects
+// all the published requests and executes them in one pass, and drops the
+// records of the threads that have exited along the way.
+template <typename Request> class publication_list {
+  static constexpr size_t cache_line_size = 64;
+
+  struct alignas(cache_line_size) record {
+    std::atomic<Request*> request{};
+    std::atomic<bool> detached{}; // the thread has exited
+  };
+
+  // The record is owned by the list. The thread only keeps a weak reference,
+  // so that the record goes away with the list, and a plain pointer to
+  // publish through.
+  struct registration {
+    uint64_t list_id;
+    std::weak_ptr<record> owner;
+    record* rec;
+  };
+
+  // The records of the calling thread in all the lists of this type it
+  // published to. They are detached when the thread exits.
+  struct thread_registrations {
+    std::vector<registration> entries;
+
+    ~thread_registrations() {
+      for (auto& r : entries)
+        if (auto rec = r.owner.lock())
+          rec->detached.store(true, std::memory_order_release);
+    }
+  };
+
+  static thread_registrations& this_thread_registrations() noexcept {
+    static thread_local thread_registrations registrations;
+    return registrations;
+  }
+
+  static inline std::atomic<uint64_t> next_list_id{1};
+
+  uint64_t id_ = next_list_id.fetch_add(1, std::memory_order_relaxed);
+
+  // The records of all threads. records_version_ changes whenever a record
+  // is added or removed.
+  spinlock records_mutex_;
+  std::vector<std::shared_ptr<record>> records_;
+  std::atomic<uint64_t> records_version_{};
+
+  // The combiner works off a copy of the records, refreshed when the version
+  // changes, so that registering does not have to wait for a combining pass.
+  std::vector<record*> combined_;
+  uint64_t combined_version_{};
+
+  record* local_record() noexcept {
+    for (auto& r : this_thread_registrations().entries)
+      if (r.list_id == id_)
+        return r.rec;
+
+    try {
+      return register_thread();
+    } catch (...) {
+      return nullptr;
+    }
+  }
+
+  record* register_thread() {
+    auto& entries = this_thread_registrations().entries;
+    // Forget the records of the lists that are gone.
+    std::erase_if(entries,
+                  [](const registration& r) { return r.owner.expired(); });
+    entries.reserve(entries.size() + 1);
+
+    auto rec = std::make_shared<record>();
+    {
+      std::unique_lock lock(records_mutex_);
+      records_.push_back(rec);
+      records_version_.fetch_add(1, std::memory_order_release);
+    }
+    entries.push_back({id_, rec, rec.get()});
+    return rec.get();
+  }
+
+  void refresh() {
+    std::unique_lock lock(records_mutex_);
+    combined_.clear();
+    for (auto& rec : records_)
+      combined_.push_back(rec.get());
+    combined_version_ = records_version_.load(std::memory_order_relaxed);
+  }
+
+  // An exited thread has nothing pending, so its record can go.
+  void drop_detached() {
+    std::unique_lock lock(records_mutex_);
+    std::erase_if(records_, [](const auto& rec) {
+      return rec->detached.load(std::memory_order_acquire);
+    });
+    records_version_.fetch_add(1, std::memory_order_release);
+  }
+
+public:
+  // Returns false if the calling thread could not be registered, in which
+  // case the request has to be executed the regular way. The request must
+  // be finished before the thread publishes another one.
+  bool publish(Request* request) noexcept {
+    auto* rec = local_record();
+    if (!rec)
+      return false;
+
+    rec->request.store(request, std::memory_order_release);
+    return true;
+  }
+
+  // Takes ownership of every published request and hands it to `f`. Must
+  // only be called by the holder of the lock the requests are combined
+  // under. Returns the number of requests collected.
+  template <typename F> size_t collect(F&& f) {
+    if (records_version_.load(std::memory_order_acquire) != combined_version_)
+      refresh();
+
+    size_t collected = 0;
+    bool detached = false;
+    for (auto* rec : combined_) {
+      if (rec->request.load(std::memory_order_relaxed) != nullptr) {
+        if (auto* request =
+                rec->request.exchange(nullptr, std::memory_order_acquire)) {
+          f(request);
+          ++collected;
+        }
+      } else if (rec->detached.load(std::memory_order_relaxed)) {
+        detached = true;
+      }
+    }
+    if (detached)
+      drop_detached();
+    return collected;
+  }
+};
+
+} // namespace std::experimental::__detail
+
+#endif // _STD_EXPERIMENTAL_CONQUEUE_FLAT_COMBINING
@@ -0,0 +1,48 @@
+// Copyright (c) 2023 Gor Nishanov
+// Licensed under MIT license. See LICENSE.txt for details.
+
+#ifndef _STD_EXPERIMENTAL_CONQUEUE_HANDOFF_FLAG
+#define _STD_EXPERIMENTAL_CONQUEUE_HANDOFF_FLAG
+
+#include <atomic>
+#include <cstdint>
+
+namespace std::experimental::__detail {
+
+// A one-shot flag used to hand a completed operation back to a blocked
+// thread. The waiter spins for a short while before parking on the futex,
+// and the signaller only issues a wake up if the waiter actually parked, so
+// a partner that shows up promptly completes the exchange with a single
+// atomic exchange and no system calls on either side.
+class handoff_flag {
+  enum : uint32_t { idle, parked, signaled };
+
+  static constexpr int spin_count = 128;
+
+  std::atomic<uint32_t> state_{idle};
+
+public:
+  void signal() noexcept {
+    if (state_.exchange(signaled, std::memory_order_acq_rel) == parked)
+      state_.notify_one();
+  }
+
+  void wait() noexcept {
+    for (int i = 0; i < spin_count; ++i)
+      if (state_.load(std::memory_order_acquire) == signaled)
+        return;
+
+    uint32_t expected = idle;
+    if (!state_.compare_exchange_strong(expected, parked,
+                                        std::memory_order_acq_rel))
+      return; // signaled while we were spinning
+
+    // wait may wake up spuriously, hence the loop.
+    while (state_.load(std::memory_order_acquire) != signaled)
+      state_.wait(parked, std::memory_order_acquire);
+  }
+};
+
+} // namespace std::experimental::__detail
+
+#endif // _STD_EXPERIMENTAL_CONQUEUE_HANDOFF_FLAG
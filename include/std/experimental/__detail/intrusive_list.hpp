@@ -49,6 +49,18 @@ public:
     tail_ = obj;
   }
 
+  // Insert an object right after pos, which is in the list
+  void insert_after(_Item* pos, _Item* obj) {
+    _Item* next = pos->*_Next;
+    obj->*_Prev = pos;
+    obj->*_Next = next;
+    pos->*_Next = obj;
+    if (next)
+      next->*_Prev = obj;
+    else
+      tail_ = obj;
+  }
+
   // Remove an object from the front of the list and return it
   [[nodiscard]] _Item* try_pop_front() {
     // Check if the list is empty
@@ -143,11 +155,55 @@ public:
   // Get the tail pointer of the list
   _Item* back() const { return tail_; }
 
+  // Get the object that follows obj, going from front to back
+  static _Item* next(_Item* obj) { return obj->*_Next; }
+
+  // Get the object that precedes obj, going from front to back
+  static _Item* prev(_Item* obj) { return obj->*_Prev; }
+
 private:
   // Pointers to the first and last objects of the list
   _Item* head_{};
   _Item* tail_{};
 };
+
+// A singly-linked FIFO for the waiters that were taken off an intrusive_list
+// under a lock and are completed once the lock is dropped. It links them
+// through a pointer of their own, so that their intrusive_list links stay
+// null and a concurrent try_remove sees them as already removed.
+template <auto _Next> class intrusive_slist;
+
+template <class _Item, _Item* _Item::*_Next> class intrusive_slist<_Next> {
+public:
+  [[nodiscard]] bool empty() const { return head_ == nullptr; }
+
+  // Insert an object at the back of the list
+  void push_back(_Item* obj) {
+    obj->*_Next = nullptr;
+    if (tail_)
+      tail_->*_Next = obj;
+    else
+      head_ = obj;
+    tail_ = obj;
+  }
+
+  // Remove an object from the front of the list and return it
+  [[nodiscard]] _Item* try_pop_front() {
+    _Item* obj = head_;
+    if (!obj)
+      return nullptr;
+
+    head_ = obj->*_Next;
+    if (!head_)
+      tail_ = nullptr;
+    obj->*_Next = nullptr;
+    return obj;
+  }
+
+private:
+  _Item* head_{};
+  _Item* tail_{};
+};
 } // namespace std::experimental::__detail
 
 #endif // _STD_EXPERIMENTAL_CONQUEUE_INTRUSIVE_LIST
@@ -71,6 +71,12 @@ public:
     size_++;
   }
 
+  // The element i positions after the front.
+  T& operator[](size_t i) noexcept {
+    assert(i < size_);
+    return buffer_[index_of(i)];
+  }
+
   T pop_front() {
     assert(not empty());
     T& ref = buffer_[head_];
@@ -0,0 +1,86 @@
+// Copyright (c) 2023 Gor Nishanov
+// Licensed under MIT license. See LICENSE.txt for details.
+
+#ifndef _STD_EXPERIMENTAL_CONQUEUE_SPILL_STORE
+#define _STD_EXPERIMENTAL_CONQUEUE_SPILL_STORE
+
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace std::experimental::__detail {
+
+// Segment files on local disk holding the elements a queue could not keep in
+// memory, as length prefixed records in append order. Segments are memory
+// mapped and their files are unlinked right after they are created, so
+// nothing is left behind if the process goes away. Fully consumed segments
+// are kept for reuse, up to a limit.
+//
+// The store does no synchronization of its own. Once claimed, the bytes of a
+// record may be read without holding the lock that protects the store, until
+// the record is released. Creating a segment takes several system calls and
+// page faults, so the store never does it on its own: make_segment may be
+// called without holding the lock and the result is handed to add_segment.
+class spill_store {
+public:
+  struct segment {
+    int fd = -1;
+    std::byte* base{};
+    size_t size{};
+    size_t write_pos{};
+    size_t read_pos{};
+    size_t unreleased{}; // claimed records that were not released yet
+
+    segment(const filesystem::path& directory, size_t size);
+    ~segment();
+  };
+
+  struct record {
+    segment* owner;
+    std::span<const std::byte> bytes;
+  };
+
+  // Segments are not created until the first record is appended.
+  spill_store(filesystem::path directory, size_t segment_size,
+              size_t max_spare_segments);
+
+  // Records appended and not claimed yet.
+  size_t size() const noexcept { return count_; }
+  bool empty() const noexcept { return count_ == 0; }
+
+  // Returns room for a record of n bytes at the end of the store, or an
+  // empty span if none of the segments at hand has room for it.
+  std::span<std::byte> try_append(size_t n);
+
+  // Creates a segment with room for a record of n bytes, with its pages
+  // already faulted in. A record larger than a segment gets a segment of its
+  // own. Safe to call without holding the lock that protects the store.
+  // Throws system_error if the segment could not be created.
+  std::unique_ptr<segment> make_segment(size_t n) const;
+
+  // Makes a segment from make_segment available to try_append.
+  void add_segment(std::unique_ptr<segment> seg);
+
+  // Claims the oldest record. Precondition: !empty().
+  record claim() noexcept;
+
+  // Releases a claimed record. Segments that are no longer needed and cannot
+  // be kept as spares are moved to `retired`, for the caller to destroy
+  // after dropping its lock, since unmapping them may take a while.
+  void release(const record& r, std::vector<std::unique_ptr<segment>>& retired);
+
+private:
+  filesystem::path directory_;
+  size_t segment_size_;
+  size_t max_spare_segments_;
+  size_t count_{};
+  std::deque<std::unique_ptr<segment>> active_; // the back one is appended to
+  std::vector<std::unique_ptr<segment>> spare_;
+};
+
+} // namespace std::experimental::__detail
+
+#endif // _STD_EXPERIMENTAL_CONQUEUE_SPILL_STORE
@@ -25,6 +25,11 @@ public:
     // lock acquired
   }
 
+  bool try_lock() {
+    // check first so that spinning callers do not steal the cache line
+    return !lock_.load(std::memory_order_relaxed) && !lock_.exchange(true);
+  }
+
   void unlock() {
     // release the lock by setting the flag to false
     lock_.store(false);
@@ -0,0 +1,107 @@
+// Copyright (c) 2023 Gor Nishanov
+// Licensed under MIT license. See LICENSE.txt for details.
+
+#ifndef _STD_EXPERIMENTAL_CONQUEUE_SPSC_RING
+#define _STD_EXPERIMENTAL_CONQUEUE_SPSC_RING
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <optional>
+
+namespace std::experimental::__detail {
+
+// A bounded wait-free ring for exactly one producer and one consumer. Each
+// side owns a cache line with its own index and a cached copy of the index
+// of the other side, which it only refreshes when the cached value says the
+// ring is full (empty). In steady state, the two sides only share the cache
+// lines of the elements themselves.
+template <typename T, typename Alloc = std::allocator<T>> class spsc_ring {
+  using alloc_traits = allocator_traits<Alloc>;
+  static constexpr size_t cache_line_size = 64;
+
+  struct alignas(cache_line_size) producer_side {
+    std::atomic<size_t> tail{};
+    size_t cached_head{};
+  };
+
+  struct alignas(cache_line_size) consumer_side {
+    std::atomic<size_t> head{};
+    size_t cached_tail{};
+  };
+
+  producer_side producer_;
+  consumer_side consumer_;
+  Alloc alloc_;
+  size_t capacity_;
+  T* buffer_;
+
+  T* slot(size_t pos) const noexcept { return buffer_ + pos % capacity_; }
+
+public:
+  explicit spsc_ring(size_t capacity, const Alloc& alloc = Alloc())
+      : alloc_(alloc), capacity_(capacity),
+        buffer_(alloc_traits::allocate(alloc_, capacity)) {
+    assert(capacity > 0);
+  }
+
+  spsc_ring(const spsc_ring&) = delete;
+  spsc_ring& operator=(const spsc_ring&) = delete;
+
+  ~spsc_ring() {
+    size_t tail = producer_.tail.load(std::memory_order_relaxed);
+    for (size_t pos = consumer_.head.load(std::memory_order_relaxed);
+         pos != tail; ++pos)
+      alloc_traits::destroy(alloc_, slot(pos));
+    alloc_traits::deallocate(alloc_, buffer_, capacity_);
+  }
+
+  size_t capacity() const noexcept { return capacity_; }
+
+  // Producer side. Returns false, leaving the value alone, if the ring is
+  // full.
+  template <typename U> bool try_push(U&& value) {
+    size_t tail = producer_.tail.load(std::memory_order_relaxed);
+    if (tail - producer_.cached_head == capacity_) {
+      producer_.cached_head = consumer_.head.load(std::memory_order_acquire);
+      if (tail - producer_.cached_head == capacity_)
+        return false;
+    }
+    alloc_traits::construct(alloc_, slot(tail), std::forward<U>(value));
+    producer_.tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Producer side.
+  bool full() const noexcept {
+    return producer_.tail.load(std::memory_order_relaxed) -
+               consumer_.head.load(std::memory_order_acquire) ==
+           capacity_;
+  }
+
+  // Consumer side.
+  std::optional<T> try_pop() {
+    size_t head = consumer_.head.load(std::memory_order_relaxed);
+    if (head == consumer_.cached_tail) {
+      consumer_.cached_tail = producer_.tail.load(std::memory_order_acquire);
+      if (head == consumer_.cached_tail)
+        return std::nullopt;
+    }
+    T* p = slot(head);
+    std::optional<T> result(std::move(*p));
+    alloc_traits::destroy(alloc_, p);
+    consumer_.head.store(head + 1, std::memory_order_release);
+    return result;
+  }
+
+  // Consumer side.
+  bool empty() const noexcept {
+    return consumer_.head.load(std::memory_order_relaxed) ==
+           producer_.tail.load(std::memory_order_acquire);
+  }
+};
+
+} // namespace std::experimental::__detail
+
+#endif // _STD_EXPERIMENTAL_CONQUEUE_SPSC_RING
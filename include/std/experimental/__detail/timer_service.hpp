@@ -0,0 +1,53 @@
+// Copyright (c) 2023 Gor Nishanov
+// Licensed under MIT license. See LICENSE.txt for details.
+
+#ifndef _STD_EXPERIMENTAL_CONQUEUE_TIMER_SERVICE
+#define _STD_EXPERIMENTAL_CONQUEUE_TIMER_SERVICE
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <std/experimental/__detail/intrusive_list.hpp>
+
+namespace std::experimental::__detail {
+
+struct timer_entry {
+  chrono::steady_clock::time_point deadline;
+  void (*fire)(timer_entry*) = {};
+  timer_entry* prev{};
+  timer_entry* next{};
+};
+
+// A single background thread firing the deadlines of async operations that
+// have no scheduler to ask for a timer. Deadlines are expected to be few and
+// short lived, so they are kept in a sorted list.
+class timer_service {
+public:
+  static timer_service& instance();
+
+  void add(timer_entry* entry);
+
+  // Returns true if the entry was removed before it fired. Otherwise, waits
+  // until the entry has finished firing, after which it is safe to destroy
+  // it. Must not be called from within the fire callback of the entry.
+  bool remove(timer_entry* entry);
+
+private:
+  timer_service();
+  ~timer_service();
+
+  void run();
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  intrusive_list<&timer_entry::prev, &timer_entry::next> entries;
+  timer_entry* firing{};
+  bool stopping{};
+  std::thread thread;
+};
+
+} // namespace std::experimental::__detail
+
+#endif // _STD_EXPERIMENTAL_CONQUEUE_TIMER_SERVICE
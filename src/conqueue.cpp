@@ -3,6 +3,26 @@
 
 #include "std/experimental/conqueue"
 
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+#ifdef STDEX_CONQUEUE_HAS_EVENTFD
+#include <sys/eventfd.h>
+#endif
+
+#if __has_include(<sys/mman.h>)
+#define STDEX_CONQUEUE_HAS_MMAN 1
+#include <cstdlib>
+#include <sys/mman.h>
+#endif
+
+#if __has_include(<unistd.h>)
+#include <unistd.h>
+#endif
+
 namespace std::experimental {
 
 static const char* get_string(conqueue_errc errc) {
@@ -15,6 +35,8 @@ static const char* get_string(conqueue_errc errc) {
     return "queue is full";
   case conqueue_errc::closed:
     return "queue is closed";
+  case conqueue_errc::dropped:
+    return "subscriber was dropped for lagging behind";
   default:
     return "invalid conqueue_errc value";
   }
@@ -38,4 +60,452 @@ conqueue_error::conqueue_error(const std::error_code& ec)
 
 conqueue_error::~conqueue_error() noexcept {}
 
+// byte_buffer_queue
+
+struct byte_buffer_queue::sync_reserve_waiter : reserve_waiter {
+  std::atomic_flag flag;
+
+  sync_reserve_waiter(size_t size, span<std::byte>& result,
+                      error_code& ec) noexcept
+      : reserve_waiter(size, result, ec) {
+    this->complete = [](reserve_waiter* w) noexcept {
+      auto* self = static_cast<sync_reserve_waiter*>(w);
+      STDEX_CONQUEUE_LOG("notifying sync reserve waiter %p\n", w);
+      self->flag.test_and_set();
+      self->flag.notify_one();
+    };
+  }
+
+  void wait() noexcept { flag.wait(false); }
+};
+
+struct byte_buffer_queue::sync_peek_waiter : peek_waiter {
+  std::atomic_flag flag;
+
+  sync_peek_waiter(span<const std::byte>& result, error_code& ec) noexcept
+      : peek_waiter(result, ec) {
+    this->complete = [](peek_waiter* w) noexcept {
+      auto* self = static_cast<sync_peek_waiter*>(w);
+      STDEX_CONQUEUE_LOG("notifying sync peek waiter %p\n", w);
+      self->flag.test_and_set();
+      self->flag.notify_one();
+    };
+  }
+
+  void wait() noexcept { flag.wait(false); }
+};
+
+byte_buffer_queue::byte_buffer_queue(size_t capacity) : ring(capacity) {}
+
+byte_buffer_queue::~byte_buffer_queue() noexcept { close(); }
+
+template <typename IntrusiveList>
+void byte_buffer_queue::locked_drain_waiters(unique_lock<lock_t>& lock,
+                                             IntrusiveList& waiters) {
+  while (auto* waiter = waiters.try_pop_front()) {
+    waiter->ec = conqueue_errc::closed;
+    lock.unlock();
+    waiter->complete(waiter);
+    lock.lock();
+  }
+}
+
+void byte_buffer_queue::close() noexcept {
+  std::unique_lock lock(mutex);
+  if (closed)
+    return;
+  closed = true;
+  locked_drain_waiters(lock, reserve_waiters);
+  locked_drain_waiters(lock, peek_waiters);
+}
+
+// Reserves space for the waiting producers, in order, for as long as their
+// messages fit. The caller completes them after dropping the lock.
+void byte_buffer_queue::locked_grant_reservations(
+    released_reserve_list& granted) noexcept {
+  while (auto* waiter = reserve_waiters.front()) {
+    auto result = ring.try_reserve(waiter->size);
+    if (!result.data())
+      break;
+
+    reserve_waiters.remove(waiter);
+    waiter->result = result;
+    waiter->ec = {};
+    granted.push_back(waiter);
+  }
+}
+
+// Hands committed messages to the waiting consumers. The caller completes
+// them after dropping the lock.
+void byte_buffer_queue::locked_deliver(
+    released_peek_list& delivered) noexcept {
+  while (auto* waiter = peek_waiters.front()) {
+    auto message = ring.try_read();
+    if (!message.data())
+      break;
+
+    peek_waiters.remove(waiter);
+    waiter->result = message;
+    waiter->ec = {};
+    delivered.push_back(waiter);
+  }
+}
+
+span<std::byte> byte_buffer_queue::reserve_impl(size_t n, error_code& ec,
+                                                bool error_on_full) {
+  if (n > max_message_size()) {
+    ec = make_error_code(errc::message_size);
+    return {};
+  }
+
+  std::unique_lock lock(mutex);
+  if (closed) {
+    ec = conqueue_errc::closed;
+    return {};
+  }
+
+  // Do not overtake the reservations that are already waiting.
+  if (reserve_waiters.empty()) {
+    if (auto result = ring.try_reserve(n); result.data()) {
+      ec = {};
+      return result;
+    }
+  }
+
+  if (error_on_full) {
+    ec = conqueue_errc::full;
+    return {};
+  }
+
+  span<std::byte> result;
+  sync_reserve_waiter waiter(n, result, ec);
+  STDEX_CONQUEUE_LOG("reserve: not enough room, putting %p in the waiters "
+                     "queue\n",
+                     &waiter);
+  reserve_waiters.push_back(&waiter);
+  lock.unlock();
+  waiter.wait();
+  STDEX_CONQUEUE_LOG("reserve: %p was just resumed\n", &waiter);
+  return result;
+}
+
+span<std::byte> byte_buffer_queue::reserve(size_t n) {
+  error_code ec;
+  auto result = reserve_impl(n, ec);
+  if (ec)
+    throw conqueue_error(ec);
+  return result;
+}
+
+span<std::byte> byte_buffer_queue::reserve(size_t n, error_code& ec) {
+  return reserve_impl(n, ec);
+}
+
+span<std::byte> byte_buffer_queue::try_reserve(size_t n, error_code& ec) {
+  return reserve_impl(n, ec, true);
+}
+
+void byte_buffer_queue::commit(span<std::byte> message) noexcept {
+  std::unique_lock lock(mutex);
+  ring.commit(message);
+  released_peek_list delivered;
+  locked_deliver(delivered);
+  lock.unlock();
+
+  while (auto* waiter = delivered.try_pop_front()) {
+    STDEX_CONQUEUE_LOG("unlocking reader %p\n", waiter);
+    waiter->complete(waiter);
+  }
+}
+
+span<const std::byte> byte_buffer_queue::peek_impl(error_code& ec,
+                                                   bool error_on_empty) {
+  std::unique_lock lock(mutex);
+  if (auto message = ring.try_read(); message.data()) {
+    ec = {};
+    return message;
+  }
+
+  if (closed) {
+    ec = conqueue_errc::closed;
+    return {};
+  }
+
+  if (error_on_empty) {
+    ec = conqueue_errc::empty;
+    return {};
+  }
+
+  span<const std::byte> result;
+  sync_peek_waiter waiter(result, ec);
+  STDEX_CONQUEUE_LOG("peek: queue is empty, putting %p in the waiters queue\n",
+                     &waiter);
+  peek_waiters.push_back(&waiter);
+  lock.unlock();
+  waiter.wait();
+  STDEX_CONQUEUE_LOG("peek: %p was just resumed\n", &waiter);
+  return result;
+}
+
+span<const std::byte> byte_buffer_queue::peek() {
+  error_code ec;
+  auto result = peek_impl(ec);
+  if (ec)
+    throw conqueue_error(ec);
+  return result;
+}
+
+span<const std::byte> byte_buffer_queue::peek(error_code& ec) {
+  return peek_impl(ec);
+}
+
+span<const std::byte> byte_buffer_queue::try_peek(error_code& ec) {
+  return peek_impl(ec, true);
+}
+
+void byte_buffer_queue::release(span<const std::byte> message) noexcept {
+  std::unique_lock lock(mutex);
+  if (!ring.release(message))
+    return;
+
+  released_reserve_list granted;
+  locked_grant_reservations(granted);
+  lock.unlock();
+
+  while (auto* waiter = granted.try_pop_front()) {
+    STDEX_CONQUEUE_LOG("unlocking producer %p\n", waiter);
+    waiter->complete(waiter);
+  }
+}
+
+namespace __detail {
+
+timer_service& timer_service::instance() {
+  static timer_service service;
+  return service;
+}
+
+timer_service::timer_service() : thread([this] { run(); }) {}
+
+timer_service::~timer_service() {
+  {
+    std::lock_guard lock(mutex);
+    stopping = true;
+  }
+  cv.notify_all();
+  thread.join();
+}
+
+void timer_service::add(timer_entry* entry) {
+  std::lock_guard lock(mutex);
+  // Keep the list sorted by deadline, searching from the back since new
+  // deadlines tend to be the latest ones.
+  timer_entry* pos = entries.back();
+  while (pos && entry->deadline < pos->deadline)
+    pos = entries.prev(pos);
+
+  if (pos)
+    entries.insert_after(pos, entry);
+  else
+    entries.push_front(entry);
+
+  // The timer thread only needs to wake up if the earliest deadline changed.
+  if (entries.front() == entry)
+    cv.notify_all();
+}
+
+bool timer_service::remove(timer_entry* entry) {
+  std::unique_lock lock(mutex);
+  if (entries.try_remove(entry))
+    return true;
+
+  cv.wait(lock, [&] { return firing != entry; });
+  return false;
+}
+
+void timer_service::run() {
+  std::unique_lock lock(mutex);
+  while (!stopping) {
+    auto* entry = entries.front();
+    if (!entry) {
+      cv.wait(lock);
+      continue;
+    }
+
+    // The entry may be removed while we wait, so do not hold on to it.
+    auto deadline = entry->deadline;
+    if (chrono::steady_clock::now() < deadline) {
+      cv.wait_until(lock, deadline);
+      continue;
+    }
+
+    entries.remove(entry);
+    firing = entry;
+    lock.unlock();
+    entry->fire(entry);
+    lock.lock();
+    firing = nullptr;
+    cv.notify_all();
+  }
+}
+
+spill_store::segment::segment(const filesystem::path& directory, size_t size)
+    : size(size) {
+#ifdef STDEX_CONQUEUE_HAS_MMAN
+  std::string name = (directory / "conqueue-spill-XXXXXX").string();
+  fd = ::mkstemp(name.data());
+  if (fd < 0)
+    throw system_error(errno, system_category(), "spill segment " + name);
+
+  // Only the descriptor keeps the file alive from now on.
+  ::unlink(name.c_str());
+  if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    int err = errno;
+    ::close(fd);
+    throw system_error(err, system_category(), "spill segment ftruncate");
+  }
+
+  void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (p == MAP_FAILED) {
+    int err = errno;
+    ::close(fd);
+    throw system_error(err, system_category(), "spill segment mmap");
+  }
+  base = static_cast<std::byte*>(p);
+
+  // Fault in the pages now rather than on the first append to each of them.
+  size_t page_size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+  for (size_t offset = 0; offset < size; offset += page_size)
+    base[offset] = std::byte{};
+#else
+  (void)directory;
+  throw system_error(make_error_code(errc::not_supported), "spill segment");
+#endif
+}
+
+spill_store::segment::~segment() {
+#ifdef STDEX_CONQUEUE_HAS_MMAN
+  ::munmap(base, size);
+  ::close(fd);
+#endif
+}
+
+namespace {
+
+// Every record starts with its length and is padded so that the next one
+// starts on an 8 byte boundary.
+constexpr size_t spill_header_size = sizeof(uint64_t);
+
+size_t spill_record_size(size_t n) noexcept {
+  return (spill_header_size + n + 7) & ~size_t(7);
+}
+
+} // namespace
+
+spill_store::spill_store(filesystem::path directory, size_t segment_size,
+                         size_t max_spare_segments)
+    : directory_(std::move(directory)),
+      segment_size_(spill_record_size(segment_size)),
+      max_spare_segments_(max_spare_segments) {}
+
+std::span<std::byte> spill_store::try_append(size_t n) {
+  size_t size = spill_record_size(n);
+  if (active_.empty() ||
+      active_.back()->size - active_.back()->write_pos < size) {
+    // Take the most recently added spare that is large enough.
+    auto it = std::find_if(spare_.rbegin(), spare_.rend(),
+                           [size](auto& seg) { return seg->size >= size; });
+    if (it == spare_.rend())
+      return {};
+
+    auto seg = std::move(*it);
+    spare_.erase(std::next(it).base());
+    seg->write_pos = seg->read_pos = 0;
+    active_.push_back(std::move(seg));
+  }
+
+  auto& seg = *active_.back();
+  uint64_t length = n;
+  std::memcpy(seg.base + seg.write_pos, &length, sizeof(length));
+  std::span<std::byte> payload(seg.base + seg.write_pos + spill_header_size,
+                               n);
+  seg.write_pos += size;
+  ++count_;
+  return payload;
+}
+
+std::unique_ptr<spill_store::segment>
+spill_store::make_segment(size_t n) const {
+  return std::make_unique<segment>(
+      directory_, std::max(spill_record_size(n), segment_size_));
+}
+
+void spill_store::add_segment(std::unique_ptr<segment> seg) {
+  spare_.push_back(std::move(seg));
+}
+
+spill_store::record spill_store::claim() noexcept {
+  assert(!empty());
+  // Segments at the front may be fully read, but still waiting for their
+  // records to be released.
+  for (auto& seg : active_) {
+    if (seg->read_pos == seg->write_pos)
+      continue;
+
+    uint64_t length;
+    std::memcpy(&length, seg->base + seg->read_pos, sizeof(length));
+    std::span<const std::byte> bytes(
+        seg->base + seg->read_pos + spill_header_size, length);
+    seg->read_pos += spill_record_size(length);
+    ++seg->unreleased;
+    --count_;
+    return {seg.get(), bytes};
+  }
+  std::terminate(); // unreachable with !empty()
+}
+
+void spill_store::release(const record& r,
+                          std::vector<std::unique_ptr<segment>>& retired) {
+  --r.owner->unreleased;
+
+  while (!active_.empty()) {
+    auto& front = *active_.front();
+    if (front.read_pos != front.write_pos || front.unreleased != 0)
+      break;
+
+    // Keep appending to the last segment, starting over at its beginning.
+    if (active_.size() == 1) {
+      front.read_pos = front.write_pos = 0;
+      break;
+    }
+
+    auto seg = std::move(active_.front());
+    active_.pop_front();
+    if (seg->size == segment_size_ && spare_.size() < max_spare_segments_)
+      spare_.push_back(std::move(seg));
+    else
+      retired.push_back(std::move(seg));
+  }
+}
+
+#ifdef STDEX_CONQUEUE_HAS_EVENTFD
+
+eventfd::eventfd() : fd_(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+  if (fd_ < 0)
+    throw system_error(errno, system_category(), "eventfd");
+}
+
+eventfd::~eventfd() { ::close(fd_); }
+
+void eventfd::signal() noexcept {
+  uint64_t one = 1;
+  // Can only fail if the counter would overflow, in which case the
+  // descriptor is readable anyway.
+  [[maybe_unused]] auto n = ::write(fd_, &one, sizeof(one));
+}
+
+#endif // STDEX_CONQUEUE_HAS_EVENTFD
+
+} // namespace __detail
+
 } // namespace std::experimental
\ No newline at end of file
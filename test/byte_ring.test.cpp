@@ -0,0 +1,95 @@
+#include "std/experimental/__detail/byte_ring.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstring>
+#include <string_view>
+
+using namespace std::experimental::__detail;
+
+namespace {
+
+std::span<std::byte> write(byte_ring& ring, std::string_view text) {
+  auto record = ring.try_reserve(text.size());
+  if (record.data())
+    std::memcpy(record.data(), text.data(), text.size());
+  return record;
+}
+
+std::string_view as_text(std::span<std::byte> record) {
+  return {reinterpret_cast<const char*>(record.data()), record.size()};
+}
+
+} // namespace
+
+TEST_CASE("byte_ring: records are read in order") {
+  byte_ring ring(64);
+  REQUIRE(ring.capacity() == 64);
+  REQUIRE(ring.max_record_size() == 56);
+  REQUIRE(ring.empty());
+
+  ring.commit(write(ring, "hello"));
+  ring.commit(write(ring, "world!"));
+  REQUIRE(ring.used() == 32);
+
+  auto first = ring.try_read();
+  REQUIRE(as_text(first) == "hello");
+  auto second = ring.try_read();
+  REQUIRE(as_text(second) == "world!");
+  REQUIRE(ring.try_read().data() == nullptr);
+
+  REQUIRE(ring.release(first));
+  REQUIRE(ring.release(second));
+  REQUIRE(ring.empty());
+}
+
+TEST_CASE("byte_ring: uncommitted records block readers") {
+  byte_ring ring(64);
+  auto first = write(ring, "one");
+  ring.commit(write(ring, "two"));
+  REQUIRE_FALSE(ring.readable());
+
+  ring.commit(first.first(2));
+  REQUIRE(as_text(ring.try_read()) == "on");
+  REQUIRE(as_text(ring.try_read()) == "two");
+}
+
+TEST_CASE("byte_ring: space is reclaimed in order") {
+  byte_ring ring(48);
+  ring.commit(write(ring, "aaaaaaaa"));
+  ring.commit(write(ring, "bbbbbbbb"));
+  ring.commit(write(ring, "cccccccc"));
+  REQUIRE(ring.try_reserve(1).data() == nullptr);
+
+  auto a = ring.try_read();
+  auto b = ring.try_read();
+  // Releasing out of order does not free anything until the oldest goes.
+  REQUIRE_FALSE(ring.release(b));
+  REQUIRE(ring.used() == 48);
+  REQUIRE(ring.release(a));
+  REQUIRE(ring.used() == 16);
+}
+
+TEST_CASE("byte_ring: wraps around with padding") {
+  byte_ring ring(64);
+  ring.commit(write(ring, std::string_view("0123456789abcdef0123")));
+  ring.commit(write(ring, "xy"));
+  ring.release(ring.try_read());
+  // 16 bytes are left at the end of the buffer, not enough for 20 bytes of
+  // payload, so the record goes to the front after a padding record.
+  auto wrapped = write(ring, std::string_view("fedcba9876543210fedc"));
+  REQUIRE(wrapped.data() != nullptr);
+  ring.commit(wrapped);
+  REQUIRE(ring.used() == 64);
+
+  REQUIRE(as_text(ring.try_read()) == "xy");
+  REQUIRE(as_text(ring.try_read()) == "fedcba9876543210fedc");
+}
+
+TEST_CASE("byte_ring: largest record fits once empty") {
+  byte_ring ring(64);
+  ring.commit(write(ring, "abc"));
+  auto record = ring.try_read();
+  REQUIRE(ring.try_reserve(ring.max_record_size()).data() == nullptr);
+  ring.release(record);
+  REQUIRE(ring.try_reserve(ring.max_record_size()).size() == 56);
+}
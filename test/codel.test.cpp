@@ -0,0 +1,67 @@
+#include "std/experimental/__detail/codel.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+using namespace std::chrono_literals;
+using namespace std::experimental::__detail;
+
+using clock_type = codel_controller::clock;
+
+TEST_CASE("codel: no drops below target") {
+  codel_controller codel(5ms, 100ms);
+  auto now = clock_type::now();
+  for (int i = 0; i < 100; ++i) {
+    REQUIRE_FALSE(codel.should_drop(now, 1ms, false));
+    now += 10ms;
+  }
+  REQUIRE_FALSE(codel.dropping());
+}
+
+TEST_CASE("codel: drops once above target for an interval") {
+  codel_controller codel(5ms, 100ms);
+  auto start = clock_type::now();
+
+  // The first element above target starts the interval.
+  REQUIRE_FALSE(codel.should_drop(start, 10ms, false));
+  REQUIRE_FALSE(codel.should_drop(start + 50ms, 10ms, false));
+  // The interval elapsed with the delay still above target.
+  REQUIRE(codel.should_drop(start + 100ms, 10ms, false));
+  REQUIRE(codel.dropping());
+
+  // The next drop is scheduled one interval later.
+  REQUIRE_FALSE(codel.should_drop(start + 150ms, 10ms, false));
+  REQUIRE(codel.should_drop(start + 200ms, 10ms, false));
+
+  // ... and then at interval / sqrt(2).
+  REQUIRE_FALSE(codel.should_drop(start + 260ms, 10ms, false));
+  REQUIRE(codel.should_drop(start + 271ms, 10ms, false));
+
+  // Going back below target leaves the dropping state.
+  REQUIRE_FALSE(codel.should_drop(start + 300ms, 1ms, false));
+  REQUIRE_FALSE(codel.dropping());
+}
+
+TEST_CASE("codel: never drops the last element") {
+  codel_controller codel(5ms, 100ms);
+  auto start = clock_type::now();
+  REQUIRE_FALSE(codel.should_drop(start, 10ms, false));
+  REQUIRE_FALSE(codel.should_drop(start + 200ms, 10ms, true));
+  REQUIRE_FALSE(codel.dropping());
+}
+
+TEST_CASE("sojourn_histogram: percentiles") {
+  sojourn_histogram h;
+  REQUIRE(h.count() == 0);
+  REQUIRE(h.percentile(0.5) == 0ns);
+
+  for (int i = 0; i < 90; ++i)
+    h.record(100ns);
+  for (int i = 0; i < 10; ++i)
+    h.record(1ms);
+
+  REQUIRE(h.count() == 100);
+  REQUIRE(h.max() == 1ms);
+  // 100ns falls in the [64ns, 128ns) bucket.
+  REQUIRE(h.percentile(0.5) == 127ns);
+  REQUIRE(h.percentile(0.9) == 127ns);
+  REQUIRE(h.percentile(0.99) == 1ms);
+}
@@ -9,9 +9,24 @@
 
 #include <stdexec/execution.hpp>
 
+#include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <system_error>
 #include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef STDEX_CONQUEUE_HAS_EVENTFD
+#include <poll.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 using namespace std::experimental;
@@ -82,7 +97,8 @@ TEST_CASE("conqueue: blocking pull then closed") {
   t.join();
 }
 
-exec::task<void> coro_push(buffer_queue<int>& q, int from = 3, int to = 4) {
+template <typename Queue>
+exec::task<void> coro_push(Queue& q, int from = 3, int to = 4) {
   for (; from <= to; ++from)
     co_await q.async_push(from);
 }
@@ -104,7 +120,8 @@ TEST_CASE("conqueue: coro_push") {
   stdexec::sync_wait(scope.on_empty());
 }
 
-exec::task<void> coro_pop(buffer_queue<int>& q) {
+template <typename Queue>
+exec::task<void> coro_pop(Queue& q) {
   REQUIRE(co_await q.async_pop() == 1);
   REQUIRE(co_await q.async_pop() == 2);
   REQUIRE(co_await q.async_pop() == 3);
@@ -156,7 +173,8 @@ TEST_CASE("conqueue: coro_push rendezvous") {
   stdexec::sync_wait(scope.on_empty());
 }
 
-exec::task<void> coro_stuck_pop(buffer_queue<int>& q) {
+template <typename Queue>
+exec::task<void> coro_stuck_pop(Queue& q) {
   co_await q.async_pop();
 }
 
@@ -183,3 +201,1430 @@ TEST_CASE("conqueue: cancellation async_push") {
   scope.request_stop();
   stdexec::sync_wait(scope.on_empty());
 }
+
+TEST_CASE("conqueue: occupancy observers") {
+  buffer_queue<int> q(2);
+  REQUIRE(q.empty());
+  REQUIRE_FALSE(q.full());
+  REQUIRE(q.size() == 0);
+  q.push(1);
+  REQUIRE(q.size() == 1);
+  q.push(2);
+  REQUIRE(q.full());
+  REQUIRE(q.pop() == 1);
+  REQUIRE(q.size() == 1);
+  REQUIRE(q.pop() == 2);
+  REQUIRE(q.empty());
+}
+
+TEST_CASE("conqueue: blocking watermarks") {
+  buffer_queue<int> q(4);
+  q.wait_below(1);
+
+  thread t([&q] {
+    for (int i = 0; i < 4; ++i)
+      q.push(i);
+  });
+  q.wait_above(2);
+  REQUIRE(q.size() > 2);
+
+  thread d([&q] {
+    for (int i = 0; i < 4; ++i)
+      q.pop();
+  });
+  q.wait_below(1);
+  REQUIRE(q.empty());
+  t.join();
+  d.join();
+
+  q.close();
+  error_code ec;
+  REQUIRE_FALSE(q.wait_above(0, ec));
+  REQUIRE(ec == conqueue_errc::closed);
+}
+
+TEST_CASE("conqueue: watermark waiters behind an unsatisfied one") {
+  buffer_queue<int> q(4);
+  thread high([&q] { q.wait_above(2); });
+  this_thread::sleep_for(10ms);
+  thread low([&q] { q.wait_above(0); });
+  this_thread::sleep_for(10ms);
+
+  q.push(1);
+  low.join();
+  q.push(2);
+  q.push(3);
+  high.join();
+}
+
+exec::task<void> coro_wait_below(buffer_queue<int>& q, size_t low) {
+  co_await q.async_wait_below(low);
+  REQUIRE(q.size() < low);
+}
+
+TEST_CASE("conqueue: async_wait_below") {
+  exec::static_thread_pool pool(1);
+  exec::async_scope scope;
+  buffer_queue<int> q(4);
+  for (int i = 0; i < 4; ++i)
+    q.push(i);
+
+  scope.spawn(on(pool.get_scheduler(), coro_wait_below(q, 2)));
+
+  for (int i = 0; i < 4; ++i)
+    REQUIRE(q.pop() == i);
+
+  stdexec::sync_wait(scope.on_empty());
+}
+
+namespace {
+
+// Counts the completions of an operation. The first one runs `on_first`, so
+// that a test can act between the queue releasing the operation and the
+// operation completing.
+struct completion_counter {
+  stdexec::in_place_stop_source stop;
+  std::function<void()> on_first;
+  int values = 0;
+  int errors = 0;
+  int stopped = 0;
+
+  int total() const { return values + errors + stopped; }
+};
+
+struct counting_receiver {
+  using is_receiver = void;
+
+  completion_counter* counter;
+
+  struct env {
+    completion_counter* counter;
+
+    friend stdexec::in_place_stop_token
+    tag_invoke(stdexec::get_stop_token_t, const env& e) noexcept {
+      return e.counter->stop.get_token();
+    }
+  };
+
+  void record(int& count) noexcept {
+    bool first = counter->total() == 0;
+    ++count;
+    if (first && counter->on_first)
+      counter->on_first();
+  }
+
+  template <typename... Values>
+  friend void tag_invoke(stdexec::set_value_t, counting_receiver&& r,
+                         Values&&...) noexcept {
+    r.record(r.counter->values);
+  }
+  friend void tag_invoke(stdexec::set_error_t, counting_receiver&& r,
+                         std::exception_ptr) noexcept {
+    r.record(r.counter->errors);
+  }
+  friend void tag_invoke(stdexec::set_stopped_t,
+                         counting_receiver&& r) noexcept {
+    r.record(r.counter->stopped);
+  }
+  friend env tag_invoke(stdexec::get_env_t,
+                        const counting_receiver& r) noexcept {
+    return {r.counter};
+  }
+};
+
+} // namespace
+
+TEST_CASE("conqueue: cancelling a released watermark waiter") {
+  buffer_queue<int> q(4);
+  completion_counter a, b, c;
+  // A push releases all three. Completing the first one cancels the second,
+  // which must then complete once, with its value.
+  a.on_first = [&b] { b.stop.request_stop(); };
+  auto op_a = stdexec::connect(q.async_wait_above(0), counting_receiver{&a});
+  auto op_b = stdexec::connect(q.async_wait_above(0), counting_receiver{&b});
+  auto op_c = stdexec::connect(q.async_wait_above(0), counting_receiver{&c});
+  stdexec::start(op_a);
+  stdexec::start(op_b);
+  stdexec::start(op_c);
+
+  q.push(1);
+  REQUIRE(a.total() == 1);
+  REQUIRE(b.total() == 1);
+  REQUIRE(b.values == 1);
+  REQUIRE(c.total() == 1);
+}
+
+TEST_CASE("conqueue: cancelling a released pusher") {
+  buffer_queue<int> q(3);
+  q.push(1);
+  q.push(2);
+  q.push(3);
+
+  // The batch releases all four pushers at once. Completing the second one
+  // requests stop on the third, whose value is already in the batch.
+  completion_counter a, b, c, d;
+  b.on_first = [&c] { c.stop.request_stop(); };
+  auto op_a = stdexec::connect(q.async_push(4), counting_receiver{&a});
+  auto op_b = stdexec::connect(q.async_push(5), counting_receiver{&b});
+  auto op_c = stdexec::connect(q.async_push(6), counting_receiver{&c});
+  auto op_d = stdexec::connect(q.async_push(7), counting_receiver{&d});
+  stdexec::start(op_a);
+  stdexec::start(op_b);
+  stdexec::start(op_c);
+  stdexec::start(op_d);
+
+  REQUIRE(q.pop_batch(4, 0ns) == std::vector<int>{1, 2, 3, 4});
+  REQUIRE(a.total() == 1);
+  REQUIRE(b.total() == 1);
+  REQUIRE(c.total() == 1);
+  REQUIRE(c.values == 1);
+  REQUIRE(d.total() == 1);
+  REQUIRE(q.size() == 3);
+}
+
+namespace {
+
+// A clock for CoDel that only moves when told to.
+struct manual_clock {
+  chrono::steady_clock::time_point now{1h};
+
+  function<chrono::steady_clock::time_point()> source() {
+    return [this] { return now; };
+  }
+};
+
+} // namespace
+
+TEST_CASE("conqueue: sojourn time stats") {
+  manual_clock clock;
+  buffer_queue<int> q(4, {.codel = codel_options<int>{
+                              .drop = false, .now = clock.source()}});
+  REQUIRE(q.sojourn_time_stats().count == 0);
+  q.push(1);
+  q.push(2);
+  clock.now += 2ms;
+  REQUIRE(q.pop() == 1);
+  REQUIRE(q.pop() == 2);
+
+  auto stats = q.sojourn_time_stats();
+  REQUIRE(stats.count == 2);
+  REQUIRE(stats.dropped == 0);
+  REQUIRE(stats.max >= 2ms);
+  REQUIRE(stats.p50 <= stats.p99);
+  REQUIRE(stats.p99 <= stats.max);
+
+  buffer_queue<int> plain(4);
+  plain.push(1);
+  plain.pop();
+  REQUIRE(plain.sojourn_time_stats().count == 0);
+}
+
+TEST_CASE("conqueue: codel drops stale elements") {
+  manual_clock clock;
+  std::vector<int> dropped;
+  buffer_queue<int>* queue = nullptr;
+  buffer_queue<int> q(
+      16, {.codel = codel_options<int>{
+               .target = 1ms,
+               .interval = 10ms,
+               // Called without the lock, so the queue can be looked at.
+               .on_drop =
+                   [&](int&& x) {
+                     dropped.push_back(x);
+                     REQUIRE(queue->size() == 7);
+                   },
+               .now = clock.source()}});
+  queue = &q;
+  for (int i = 0; i < 10; ++i)
+    q.push(i);
+
+  // Standing delay above target, starts the interval.
+  clock.now += 5ms;
+  REQUIRE(q.pop() == 0);
+
+  // Still above target a full interval later: one element is dropped.
+  clock.now += 10ms;
+  REQUIRE(q.pop() == 2);
+  REQUIRE(dropped == std::vector<int>{1});
+  REQUIRE(q.sojourn_time_stats().dropped == 1);
+  REQUIRE(q.size() == 7);
+}
+
+TEST_CASE("conqueue: flat combining") {
+  buffer_queue_options<int> options;
+  options.flat_combining = true;
+
+  SECTION("semantics are preserved") {
+    buffer_queue<int> q(2, options);
+    std::error_code ec;
+    q.push(1);
+    q.push(2);
+    REQUIRE_FALSE(q.try_push(3, ec));
+    REQUIRE(ec == conqueue_errc::full);
+    REQUIRE(q.pop() == 1);
+    REQUIRE(q.pop() == 2);
+    REQUIRE_FALSE(q.try_pop(ec));
+    REQUIRE(ec == conqueue_errc::empty);
+
+    thread t([&q] {
+      this_thread::sleep_for(5ms);
+      q.push(4);
+    });
+    REQUIRE(q.pop() == 4);
+    t.join();
+
+    q.close();
+    REQUIRE_FALSE(q.pop(ec));
+    REQUIRE(ec == conqueue_errc::closed);
+  }
+  SECTION("contended") {
+    constexpr int producers = 4;
+    constexpr int consumers = 4;
+    constexpr int64_t count = 10000;
+    buffer_queue<int> q(16, options);
+    std::atomic<int64_t> sum{};
+    std::vector<thread> threads;
+    for (int i = 0; i < producers; ++i)
+      threads.emplace_back([&q] {
+        for (int j = 1; j <= count; ++j)
+          q.push(j);
+      });
+    for (int i = 0; i < consumers; ++i)
+      threads.emplace_back([&q, &sum] {
+        std::error_code ec;
+        while (auto value = q.pop(ec))
+          sum += *value;
+      });
+    for (int i = 0; i < producers; ++i)
+      threads[i].join();
+    q.close();
+    for (int i = producers; i < producers + consumers; ++i)
+      threads[i].join();
+    REQUIRE(sum == producers * count * (count + 1) / 2);
+  }
+}
+
+namespace {
+
+// An element type whose next move can be made to stall until it is let go.
+struct gated_int {
+  static inline atomic<bool> stall{};
+  static inline atomic<bool> stalled{};
+  int value;
+
+  explicit gated_int(int value) : value(value) {}
+  gated_int(const gated_int&) = default;
+  gated_int(gated_int&& other) : value(other.value) {
+    if (stall.exchange(false)) {
+      stalled = true;
+      stalled.notify_all();
+      stalled.wait(true);
+    }
+  }
+  gated_int& operator=(const gated_int&) = default;
+  gated_int& operator=(gated_int&&) = default;
+};
+
+} // namespace
+
+TEST_CASE("conqueue: cancelling a popper released by the combiner") {
+  buffer_queue_options<gated_int> options;
+  options.flat_combining = true;
+  buffer_queue<gated_int> q(4, options);
+
+  // Completing the first popper requests stop on the second one, which the
+  // combiner may have released in the same batch.
+  completion_counter a, b, c;
+  a.on_first = [&b] { b.stop.request_stop(); };
+  auto op_a = stdexec::connect(q.async_pop(), counting_receiver{&a});
+  auto op_b = stdexec::connect(q.async_pop(), counting_receiver{&b});
+  auto op_c = stdexec::connect(q.async_pop(), counting_receiver{&c});
+  stdexec::start(op_a);
+  stdexec::start(op_b);
+  stdexec::start(op_c);
+
+  // The first pusher becomes the combiner and stalls while handing its value
+  // to the first popper, so that the other two publish their pushes for it.
+  // Pushes that are not published in time are executed on their own, which
+  // covers less but holds just the same.
+  gated_int::stall = true;
+  thread combiner([&q] { q.push(gated_int(1)); });
+  gated_int::stalled.wait(false);
+  thread second([&q] { q.push(gated_int(2)); });
+  thread third([&q] { q.push(gated_int(3)); });
+  this_thread::sleep_for(10ms);
+  gated_int::stalled = false;
+  gated_int::stalled.notify_all();
+  combiner.join();
+  second.join();
+  third.join();
+
+  REQUIRE(a.total() == 1);
+  REQUIRE(b.total() == 1);
+  REQUIRE(c.total() == 1);
+  REQUIRE(a.values + b.values + c.values + int(q.size()) == 3);
+}
+
+template <> struct std::experimental::spill_traits<std::string> {
+  static size_t size(const std::string& s) noexcept { return s.size(); }
+  static void serialize(const std::string& s, span<std::byte> out) noexcept {
+    std::memcpy(out.data(), s.data(), s.size());
+  }
+  static std::string deserialize(span<const std::byte> in) {
+    return {reinterpret_cast<const char*>(in.data()), in.size()};
+  }
+};
+
+// An element type whose promotion back from disk can be made to fail or to
+// stall.
+struct slow_int {
+  int value;
+};
+
+template <> struct std::experimental::spill_traits<slow_int> {
+  static inline atomic<bool> fail{};
+  static inline atomic<bool> hold{};
+  static inline atomic<bool> holding{};
+
+  static size_t size(const slow_int&) noexcept { return sizeof(int); }
+  static void serialize(const slow_int& x, span<std::byte> out) noexcept {
+    std::memcpy(out.data(), &x.value, sizeof(int));
+  }
+  static slow_int deserialize(span<const std::byte> in) {
+    holding = true;
+    while (hold)
+      this_thread::yield();
+    holding = false;
+    if (fail)
+      throw std::bad_alloc();
+    slow_int x;
+    std::memcpy(&x.value, in.data(), sizeof(int));
+    return x;
+  }
+};
+
+TEST_CASE("conqueue: spill to disk") {
+  SECTION("order is preserved") {
+    buffer_queue_options<int> options;
+    options.spill = spill_options{.segment_size = 4096};
+    buffer_queue<int> q(4, options);
+
+    // More than a segment's worth of elements does not block.
+    std::error_code ec;
+    for (int i = 0; i < 1000; ++i)
+      REQUIRE(q.try_push(i, ec));
+    REQUIRE(q.size() == 1000);
+    for (int i = 0; i < 1000; ++i)
+      REQUIRE(q.pop() == i);
+    REQUIRE_FALSE(q.try_pop(ec));
+    REQUIRE(ec == conqueue_errc::empty);
+  }
+  SECTION("spill_traits specialization") {
+    buffer_queue_options<std::string> options;
+    options.spill = spill_options{.segment_size = 64};
+    buffer_queue<std::string> q(2, options);
+    for (int i = 0; i < 20; ++i)
+      q.push(std::string(i * 10, 'a' + i));
+    q.close();
+    for (int i = 0; i < 20; ++i)
+      REQUIRE(q.pop() == std::string(i * 10, 'a' + i));
+    REQUIRE_THROWS_AS(q.pop(), conqueue_error);
+  }
+  SECTION("watermarks count spilled elements") {
+    buffer_queue_options<int> options;
+    options.spill = spill_options{.segment_size = 4096};
+    buffer_queue<int> q(2, options);
+    for (int i = 0; i < 5; ++i)
+      q.push(i);
+    REQUIRE(q.size() == 5);
+
+    q.wait_above(4);
+    completion_counter above;
+    auto op =
+        stdexec::connect(q.async_wait_above(4), counting_receiver{&above});
+    stdexec::start(op);
+    REQUIRE(above.values == 1);
+  }
+  SECTION("spilled elements keep their enqueue time") {
+    manual_clock clock;
+    buffer_queue_options<int> options;
+    options.codel = codel_options<int>{.drop = false, .now = clock.source()};
+    options.spill = spill_options{.segment_size = 4096};
+    buffer_queue<int> q(1, options);
+    q.push(1);
+    q.push(2);
+
+    // Popping 1 promotes 2, which has been waiting just as long.
+    clock.now += 10ms;
+    REQUIRE(q.pop() == 1);
+    REQUIRE(q.pop() == 2);
+    auto stats = q.sojourn_time_stats();
+    REQUIRE(stats.count == 2);
+    REQUIRE(stats.p50 >= 10ms);
+  }
+  SECTION("a failed promotion is retried") {
+    using traits = spill_traits<slow_int>;
+    buffer_queue_options<slow_int> options;
+    options.spill = spill_options{.segment_size = 4096};
+    buffer_queue<slow_int> q(2, options);
+    for (int i = 0; i < 6; ++i)
+      q.push({i});
+
+    traits::fail = true;
+    REQUIRE(q.pop().value == 0);
+    REQUIRE(q.pop().value == 1);
+    REQUIRE(q.size() == 4);
+
+    // A pop that finds the ring empty tries again, and gets the exception
+    // rather than wait for elements that are stuck in the store.
+    REQUIRE_THROWS_AS(q.pop(), std::bad_alloc);
+    std::error_code ec;
+    REQUIRE_THROWS_AS(q.try_pop(ec), std::bad_alloc);
+    traits::fail = false;
+    REQUIRE(q.pop().value == 2);
+
+    // So does the next update of the queue.
+    traits::fail = true;
+    REQUIRE(q.pop().value == 3);
+    REQUIRE(q.pop().value == 4);
+    traits::fail = false;
+    q.push({6});
+    for (int i = 5; i < 7; ++i)
+      REQUIRE(q.pop().value == i);
+  }
+  SECTION("consumers waiting for a failed promotion get the exception") {
+    using traits = spill_traits<slow_int>;
+    buffer_queue_options<slow_int> options;
+    options.spill = spill_options{.segment_size = 4096};
+    buffer_queue<slow_int> q(1, options);
+    q.push({0});
+    q.push({1});
+
+    traits::hold = true;
+    int first = -1;
+    thread promoter([&] { first = q.pop().value; });
+    while (!traits::holding)
+      this_thread::yield();
+
+    // Waits for the element on its way back, even once the queue is closed.
+    completion_counter waiting;
+    auto op = stdexec::connect(q.async_pop(), counting_receiver{&waiting});
+    stdexec::start(op);
+    q.close();
+    REQUIRE(waiting.total() == 0);
+
+    traits::fail = true;
+    traits::hold = false;
+    promoter.join();
+    REQUIRE(first == 0);
+    REQUIRE(waiting.errors == 1);
+
+    // The element is still there for the next attempt.
+    REQUIRE(q.size() == 1);
+    REQUIRE_THROWS_AS(q.pop(), std::bad_alloc);
+    traits::fail = false;
+    REQUIRE(q.pop().value == 1);
+    REQUIRE_THROWS_AS(q.pop(), conqueue_error);
+  }
+  SECTION("close lets a promotion in flight land") {
+    using traits = spill_traits<slow_int>;
+    buffer_queue_options<slow_int> options;
+    options.spill = spill_options{.segment_size = 4096};
+    buffer_queue<slow_int> q(1, options);
+    q.push({0});
+    q.push({1});
+
+    // Popping the element in the ring starts the promotion of the spilled
+    // one, which stalls until it is let go.
+    traits::hold = true;
+    int first = -1, second = -1;
+    thread promoter([&] { first = q.pop().value; });
+    while (!traits::holding)
+      this_thread::yield();
+    thread consumer([&] {
+      std::error_code ec;
+      if (auto x = q.pop(ec))
+        second = x->value;
+    });
+    this_thread::sleep_for(10ms);
+
+    q.close();
+    traits::hold = false;
+    promoter.join();
+    consumer.join();
+    REQUIRE(first == 0);
+    REQUIRE(second == 1);
+    REQUIRE_THROWS_AS(q.pop(), conqueue_error);
+  }
+  SECTION("element type must be spillable") {
+    buffer_queue_options<std::vector<int>> options;
+    options.spill = spill_options{};
+    REQUIRE_THROWS_AS(buffer_queue<std::vector<int>>(4, options),
+                      std::invalid_argument);
+  }
+}
+
+namespace {
+
+struct throwing_move {
+  static inline bool fail = false;
+  int value;
+
+  explicit throwing_move(int value) : value(value) {}
+  throwing_move(const throwing_move&) = default;
+  throwing_move(throwing_move&& other) : value(other.value) {
+    if (fail)
+      throw std::runtime_error("move");
+  }
+  throwing_move& operator=(const throwing_move&) = default;
+  throwing_move& operator=(throwing_move&&) = default;
+};
+
+} // namespace
+
+TEST_CASE("conqueue: pop_batch") {
+  buffer_queue<int> q(8);
+  for (int i = 0; i < 5; ++i)
+    q.push(i);
+
+  SECTION("full batch is returned right away") {
+    REQUIRE(q.pop_batch(3, 1h) == std::vector<int>{0, 1, 2});
+    REQUIRE(q.size() == 2);
+  }
+  SECTION("partial batch after linger") {
+    auto start = chrono::steady_clock::now();
+    REQUIRE(q.pop_batch(8, 10ms) == std::vector<int>{0, 1, 2, 3, 4});
+    REQUIRE(chrono::steady_clock::now() - start >= 10ms);
+  }
+  SECTION("batch fills up while lingering") {
+    thread t([&q] {
+      q.wait_below(1);
+      q.push(5);
+    });
+    REQUIRE(q.pop_batch(6, 1h) == std::vector<int>{0, 1, 2, 3, 4, 5});
+    t.join();
+  }
+  SECTION("close flushes the partial batch") {
+    thread t([&q] {
+      q.wait_below(1);
+      q.close();
+    });
+    REQUIRE(q.pop_batch(8, 1h) == std::vector<int>{0, 1, 2, 3, 4});
+    REQUIRE_THROWS_AS(q.pop_batch(8, 1h), conqueue_error);
+    t.join();
+  }
+}
+
+exec::task<void> coro_pop_batch(buffer_queue<int>& q) {
+  REQUIRE(co_await q.async_pop_batch(2, 1h) == std::vector<int>{1, 2});
+  REQUIRE(co_await q.async_pop_batch(4, 10ms) == std::vector<int>{3});
+}
+
+TEST_CASE("conqueue: async_pop_batch") {
+  exec::static_thread_pool pool(1);
+  exec::async_scope scope;
+  buffer_queue<int> q(4);
+
+  scope.spawn(on(pool.get_scheduler(), coro_pop_batch(q)));
+
+  q.push(1);
+  q.push(2);
+  q.push(3);
+
+  stdexec::sync_wait(scope.on_empty());
+}
+
+exec::task<void> coro_linger(buffer_queue<int>& q, chrono::nanoseconds linger,
+                             atomic<bool>& done) {
+  REQUIRE(co_await q.async_pop_batch(2, linger) == std::vector<int>{1});
+  done = true;
+  done.notify_one();
+}
+
+TEST_CASE("conqueue: async_pop_batch deadlines fire in order") {
+  exec::static_thread_pool pool(1);
+  auto sched = pool.get_scheduler();
+  exec::async_scope scope;
+  buffer_queue<int> q_long(4), q_short(4), q_medium(4);
+  atomic<bool> long_done{}, short_done{}, medium_done{};
+  q_long.push(1);
+  q_short.push(1);
+  q_medium.push(1);
+
+  // The short linger is armed between two longer ones and has to fire first.
+  // The pool has a single thread, so the operations start in this order.
+  scope.spawn(on(sched, coro_linger(q_long, 1h, long_done)));
+  scope.spawn(on(sched, coro_linger(q_short, 10ms, short_done)));
+  scope.spawn(on(sched, coro_linger(q_medium, 1min, medium_done)));
+
+  short_done.wait(false);
+  REQUIRE_FALSE(long_done);
+  REQUIRE_FALSE(medium_done);
+
+  scope.request_stop();
+  stdexec::sync_wait(scope.on_empty());
+}
+
+TEST_CASE("conqueue: async_pop_batch reports a throwing move") {
+  buffer_queue<throwing_move> q(0);
+  completion_counter pushed, popped;
+  auto push_op = stdexec::connect(q.async_push(throwing_move(1)),
+                                  counting_receiver{&pushed});
+  stdexec::start(push_op);
+
+  // Taking the value from the pusher throws, which fails the batch and
+  // leaves the pusher blocked.
+  throwing_move::fail = true;
+  auto pop_op =
+      stdexec::connect(q.async_pop_batch(2, 1h), counting_receiver{&popped});
+  stdexec::start(pop_op);
+  throwing_move::fail = false;
+  REQUIRE(popped.errors == 1);
+  REQUIRE(pushed.total() == 0);
+
+  REQUIRE(q.pop().value == 1);
+  REQUIRE(pushed.values == 1);
+}
+
+#ifdef STDEX_CONQUEUE_HAS_EVENTFD
+static bool fd_readable(int fd) {
+  pollfd pfd{fd, POLLIN, 0};
+  return ::poll(&pfd, 1, 0) == 1;
+}
+
+static void fd_reset(int fd) {
+  uint64_t value;
+  REQUIRE(::read(fd, &value, sizeof(value)) == sizeof(value));
+}
+
+TEST_CASE("conqueue: pop_ready_fd") {
+  buffer_queue<int> q(4);
+  int fd = q.pop_ready_fd();
+  REQUIRE_FALSE(fd_readable(fd));
+
+  // Only the transition to non-empty is signaled.
+  q.push(1);
+  REQUIRE(fd_readable(fd));
+  fd_reset(fd);
+  q.push(2);
+  REQUIRE_FALSE(fd_readable(fd));
+
+  // Drain until empty, which re-arms the descriptor.
+  error_code ec;
+  while (q.try_pop(ec))
+    ;
+  REQUIRE(ec == conqueue_errc::empty);
+  q.push(3);
+  REQUIRE(fd_readable(fd));
+  fd_reset(fd);
+
+  // Any operation that empties the queue re-arms it, not just try_pop.
+  q.push(4);
+  REQUIRE(q.pop_batch(2, 0ns) == std::vector<int>{3, 4});
+  q.push(5);
+  REQUIRE(fd_readable(fd));
+  fd_reset(fd);
+
+  q.close();
+  REQUIRE(fd_readable(fd));
+}
+
+TEST_CASE("conqueue: push_ready_fd") {
+  buffer_queue<int> q(1);
+  int fd = q.push_ready_fd();
+  REQUIRE(fd_readable(fd));
+  fd_reset(fd);
+
+  error_code ec;
+  REQUIRE(q.try_push(1, ec));
+  REQUIRE_FALSE(q.try_push(2, ec));
+  REQUIRE(ec == conqueue_errc::full);
+  REQUIRE_FALSE(fd_readable(fd));
+
+  REQUIRE(q.pop() == 1);
+  REQUIRE(fd_readable(fd));
+  REQUIRE(q.push_ready_fd() == fd);
+}
+
+TEST_CASE("conqueue: push_ready_fd without capacity") {
+  buffer_queue<int> q(0);
+  int fd = q.push_ready_fd();
+  REQUIRE_FALSE(fd_readable(fd));
+  q.close();
+  REQUIRE(fd_readable(fd));
+}
+#endif
+
+TEST_CASE("rendezvous_channel: smoketest") {
+  rendezvous_channel<int> ch;
+  REQUIRE(ch.capacity() == 0);
+  REQUIRE_FALSE(ch.is_closed());
+
+  std::error_code ec;
+  REQUIRE_FALSE(ch.try_push(1, ec));
+  REQUIRE(ec == conqueue_errc::full);
+  REQUIRE_FALSE(ch.try_pop(ec));
+  REQUIRE(ec == conqueue_errc::empty);
+
+  thread t([&ch] {
+    for (int i = 1; i <= 4; ++i)
+      ch.push(i);
+    ch.close();
+  });
+
+  REQUIRE(ch.pop() == 1);
+  REQUIRE(ch.pop() == 2);
+  REQUIRE(ch.pop() == 3);
+  REQUIRE(ch.pop() == 4);
+  REQUIRE_THROWS_AS(ch.pop(), conqueue_error);
+  t.join();
+}
+
+TEST_CASE("rendezvous_channel: close releases blocked pusher") {
+  rendezvous_channel<int> ch;
+  thread t([&ch] {
+    this_thread::sleep_for(10ms);
+    ch.close();
+  });
+
+  error_code ec;
+  REQUIRE_FALSE(ch.push(1, ec));
+  REQUIRE(ec == conqueue_errc::closed);
+  REQUIRE_THROWS_AS(ch.push(2), conqueue_error);
+  t.join();
+}
+
+TEST_CASE("rendezvous_channel: a throwing move keeps the pusher waiting") {
+  rendezvous_channel<throwing_move> ch;
+  throwing_move::fail = true;
+  thread t([&ch] { ch.push(throwing_move(1)); });
+
+  // try_pop reports empty until the pusher is parked. Then moving its value
+  // throws, and the pusher stays for the next popper.
+  std::error_code ec;
+  for (bool thrown = false; !thrown;) {
+    try {
+      REQUIRE_FALSE(ch.try_pop(ec));
+    } catch (const std::runtime_error&) {
+      thrown = true;
+    }
+  }
+
+  throwing_move::fail = false;
+  REQUIRE(ch.pop().value == 1);
+  t.join();
+}
+
+TEST_CASE("rendezvous_channel: coro_pop") {
+  exec::static_thread_pool pool(1);
+  exec::async_scope scope;
+  rendezvous_channel<int> ch;
+
+  scope.spawn(on(pool.get_scheduler(), coro_pop(ch)));
+
+  ch.push(1);
+  ch.push(2);
+  ch.push(3);
+  ch.push(4);
+
+  stdexec::sync_wait(scope.on_empty());
+}
+
+TEST_CASE("rendezvous_channel: coro_push") {
+  exec::static_thread_pool pool(1);
+  exec::async_scope scope;
+  rendezvous_channel<int> ch;
+
+  scope.spawn(on(pool.get_scheduler(), coro_push(ch, 1, 4)));
+
+  REQUIRE(ch.pop() == 1);
+  REQUIRE(ch.pop() == 2);
+  REQUIRE(ch.pop() == 3);
+  REQUIRE(ch.pop() == 4);
+
+  stdexec::sync_wait(scope.on_empty());
+}
+
+TEST_CASE("rendezvous_channel: cancellation async_pop") {
+  exec::static_thread_pool pool(1);
+  auto sched = pool.get_scheduler();
+  exec::async_scope scope;
+  rendezvous_channel<int> ch;
+
+  scope.spawn(on(sched, coro_stuck_pop(ch)));
+  std::this_thread::sleep_for(10ms);
+  scope.request_stop();
+  stdexec::sync_wait(scope.on_empty());
+}
+
+namespace {
+
+void put_message(byte_buffer_queue& q, std::string_view text) {
+  auto buffer = q.reserve(text.size());
+  std::memcpy(buffer.data(), text.data(), text.size());
+  q.commit(buffer);
+}
+
+std::string as_string(std::span<const std::byte> message) {
+  return {reinterpret_cast<const char*>(message.data()), message.size()};
+}
+
+std::string take_message(byte_buffer_queue& q) {
+  auto message = q.peek();
+  auto text = as_string(message);
+  q.release(message);
+  return text;
+}
+
+} // namespace
+
+TEST_CASE("byte_buffer_queue: smoketest") {
+  byte_buffer_queue q(64);
+  REQUIRE(q.capacity() == 64);
+  REQUIRE(q.max_message_size() == 56);
+
+  put_message(q, "hello");
+  put_message(q, "world!");
+  REQUIRE(take_message(q) == "hello");
+  REQUIRE(take_message(q) == "world!");
+
+  std::error_code ec;
+  REQUIRE(q.try_peek(ec).empty());
+  REQUIRE(ec == conqueue_errc::empty);
+  REQUIRE(q.try_reserve(57, ec).empty());
+  REQUIRE(ec == errc::message_size);
+
+  // Reserve generously, commit what was actually written.
+  auto buffer = q.reserve(40);
+  REQUIRE(q.try_reserve(16, ec).empty());
+  REQUIRE(ec == conqueue_errc::full);
+  std::memcpy(buffer.data(), "abc", 3);
+  q.commit(buffer.first(3));
+  REQUIRE(take_message(q) == "abc");
+
+  q.close();
+  REQUIRE_THROWS_AS(q.peek(), conqueue_error);
+  REQUIRE_THROWS_AS(q.reserve(1), conqueue_error);
+}
+
+TEST_CASE("byte_buffer_queue: blocking on free bytes") {
+  byte_buffer_queue q(64);
+  auto first = q.reserve(40);
+  thread t([&q] { put_message(q, "a message of 26 characters"); });
+  this_thread::sleep_for(10ms);
+
+  // The second message only fits once the first one is released.
+  std::memcpy(first.data(), "x", 1);
+  q.commit(first.first(1));
+  REQUIRE(take_message(q) == "x");
+  REQUIRE(take_message(q) == "a message of 26 characters");
+  t.join();
+}
+
+exec::task<void> coro_peek(byte_buffer_queue& q) {
+  for (auto expected : {"one", "two"}) {
+    auto message = co_await q.async_peek();
+    REQUIRE(as_string(message) == expected);
+    q.release(message);
+  }
+}
+
+TEST_CASE("byte_buffer_queue: coro_peek") {
+  exec::static_thread_pool pool(1);
+  exec::async_scope scope;
+  byte_buffer_queue q(64);
+
+  scope.spawn(on(pool.get_scheduler(), coro_peek(q)));
+
+  put_message(q, "one");
+  put_message(q, "two");
+
+  stdexec::sync_wait(scope.on_empty());
+}
+
+exec::task<void> coro_reserve(byte_buffer_queue& q) {
+  for (auto text : {"one", "two"}) {
+    auto buffer = co_await q.async_reserve(32);
+    std::memcpy(buffer.data(), text, 3);
+    q.commit(buffer.first(3));
+  }
+}
+
+TEST_CASE("byte_buffer_queue: coro_reserve") {
+  exec::static_thread_pool pool(1);
+  exec::async_scope scope;
+  byte_buffer_queue q(64);
+
+  scope.spawn(on(pool.get_scheduler(), coro_reserve(q)));
+
+  REQUIRE(take_message(q) == "one");
+  REQUIRE(take_message(q) == "two");
+
+  stdexec::sync_wait(scope.on_empty());
+}
+
+TEST_CASE("byte_buffer_queue: cancelling a released reserver") {
+  byte_buffer_queue q(128);
+  auto big = q.reserve(112);
+
+  // Releasing the big reservation grants all three at once. Completing the
+  // first one requests stop on the second, which must keep its grant.
+  completion_counter a, b, c;
+  a.on_first = [&b] { b.stop.request_stop(); };
+  auto op_a = stdexec::connect(q.async_reserve(8), counting_receiver{&a});
+  auto op_b = stdexec::connect(q.async_reserve(8), counting_receiver{&b});
+  auto op_c = stdexec::connect(q.async_reserve(8), counting_receiver{&c});
+  stdexec::start(op_a);
+  stdexec::start(op_b);
+  stdexec::start(op_c);
+  REQUIRE(a.total() == 0);
+
+  q.commit(big.first(1));
+  q.release(q.peek());
+  REQUIRE(a.total() == 1);
+  REQUIRE(b.total() == 1);
+  REQUIRE(b.values == 1);
+  REQUIRE(c.total() == 1);
+}
+
+TEST_CASE("byte_buffer_queue: cancelling a released peeker") {
+  byte_buffer_queue q(128);
+
+  // Committing the first reservation delivers all three messages at once.
+  // Completing the first peeker requests stop on the second, which must
+  // still get its message.
+  completion_counter a, b, c;
+  a.on_first = [&b] { b.stop.request_stop(); };
+  auto op_a = stdexec::connect(q.async_peek(), counting_receiver{&a});
+  auto op_b = stdexec::connect(q.async_peek(), counting_receiver{&b});
+  auto op_c = stdexec::connect(q.async_peek(), counting_receiver{&c});
+  stdexec::start(op_a);
+  stdexec::start(op_b);
+  stdexec::start(op_c);
+
+  auto first = q.reserve(8);
+  auto second = q.reserve(8);
+  auto third = q.reserve(8);
+  q.commit(second);
+  q.commit(third);
+  REQUIRE(a.total() == 0);
+
+  q.commit(first);
+  REQUIRE(a.total() == 1);
+  REQUIRE(b.total() == 1);
+  REQUIRE(b.values == 1);
+  REQUIRE(c.total() == 1);
+}
+
+TEST_CASE("mpsc_buffer_queue: smoketest") {
+  mpsc_buffer_queue<int> q(2);
+  REQUIRE(q.capacity() == 2);
+
+  std::error_code ec;
+  REQUIRE_FALSE(q.try_pop(ec));
+  REQUIRE(ec == conqueue_errc::empty);
+
+  q.push(1);
+  q.push(2);
+  REQUIRE_FALSE(q.try_push(3, ec));
+  REQUIRE(ec == conqueue_errc::full);
+
+  // Another thread gets a ring of its own, the consumer takes turns.
+  thread([&q] {
+    q.push(10);
+    q.push(11);
+  }).join();
+  REQUIRE(q.pop() == 1);
+  REQUIRE(q.pop() == 10);
+  REQUIRE(q.pop() == 2);
+  REQUIRE(q.pop() == 11);
+
+  q.push(4);
+  q.close();
+  REQUIRE_FALSE(q.push(5, ec));
+  REQUIRE(ec == conqueue_errc::closed);
+  REQUIRE(q.pop() == 4);
+  REQUIRE_THROWS_AS(q.pop(), conqueue_error);
+}
+
+TEST_CASE("mpsc_buffer_queue: drain") {
+  mpsc_buffer_queue<int> q(4);
+  q.push(1);
+  q.push(2);
+  thread([&q] { q.push(3); }).join();
+
+  int sum = 0;
+  REQUIRE(q.drain([&sum](int x) { sum += x; }, 2) == 2);
+  REQUIRE(q.drain([&sum](int x) { sum += x; }) == 1);
+  REQUIRE(sum == 6);
+  REQUIRE(q.drain([](int) {}) == 0);
+}
+
+TEST_CASE("mpsc_buffer_queue: idle producers") {
+  constexpr int idle = 8;
+  mpsc_buffer_queue<int> q(2);
+
+  // Producers that pushed once and went quiet, without exiting.
+  std::atomic<bool> done{};
+  std::atomic<int> pushed{};
+  vector<thread> threads;
+  for (int i = 0; i < idle; ++i)
+    threads.emplace_back([&, i] {
+      q.push(100 + i);
+      ++pushed;
+      done.wait(false);
+    });
+  while (pushed < idle)
+    this_thread::yield();
+
+  int sum = 0;
+  REQUIRE(q.drain([&sum](int x) { sum += x; }) == idle);
+  REQUIRE(sum == idle * 100 + idle * (idle - 1) / 2);
+
+  // Only the rings that have elements take turns.
+  q.push(1);
+  q.push(2);
+  thread([&q] {
+    q.push(10);
+    q.push(11);
+  }).join();
+  REQUIRE(q.pop() == 1);
+  REQUIRE(q.pop() == 10);
+  REQUIRE(q.pop() == 2);
+  REQUIRE(q.pop() == 11);
+  std::error_code ec;
+  REQUIRE_FALSE(q.try_pop(ec));
+
+  done = true;
+  done.notify_all();
+  for (auto& t : threads)
+    t.join();
+}
+
+TEST_CASE("mpsc_buffer_queue: per producer order") {
+  constexpr int producers = 4;
+  constexpr int count = 10000;
+  mpsc_buffer_queue<int> q(8);
+
+  vector<thread> threads;
+  for (int p = 0; p < producers; ++p)
+    threads.emplace_back([&q, p] {
+      for (int i = 0; i < count; ++i)
+        q.push(p * count + i);
+    });
+
+  vector<int> next(producers);
+  for (int i = 0; i < producers * count; ++i) {
+    int x = q.pop();
+    REQUIRE(x % count == next[x / count]++);
+  }
+
+  for (auto& t : threads)
+    t.join();
+}
+
+TEST_CASE("mpsc_buffer_queue: close releases blocked producer") {
+  mpsc_buffer_queue<int> q(1);
+  thread t([&q] {
+    this_thread::sleep_for(10ms);
+    q.close();
+  });
+
+  q.push(1);
+  std::error_code ec;
+  REQUIRE_FALSE(q.push(2, ec));
+  REQUIRE(ec == conqueue_errc::closed);
+  t.join();
+  REQUIRE(q.pop() == 1);
+}
+
+TEST_CASE("mpsc_buffer_queue: unregister_producer") {
+  mpsc_buffer_queue<int> q(2);
+  q.push(1);
+  q.push(2);
+  thread([&q] { q.push(100); }).join();
+  // Moves the consumer on to the ring of the other thread.
+  REQUIRE(q.pop() == 1);
+
+  // Pushing again goes behind the element that is still in our ring.
+  q.unregister_producer();
+  q.push(3);
+  REQUIRE(q.pop() == 100);
+  REQUIRE(q.pop() == 2);
+  REQUIRE(q.pop() == 3);
+
+  // Once our ring is drained, it is dropped and the next push gets a new one.
+  q.unregister_producer();
+  error_code ec;
+  REQUIRE_FALSE(q.try_pop(ec));
+  q.push(4);
+  REQUIRE(q.pop() == 4);
+}
+
+TEST_CASE("mpsc_buffer_queue: coro_pop") {
+  exec::static_thread_pool pool(1);
+  exec::async_scope scope;
+  mpsc_buffer_queue<int> q(2);
+
+  scope.spawn(on(pool.get_scheduler(), coro_pop(q)));
+
+  q.push(1);
+  q.push(2);
+  q.push(3);
+  q.push(4);
+
+  stdexec::sync_wait(scope.on_empty());
+}
+
+TEST_CASE("mpsc_buffer_queue: cancellation async_pop") {
+  exec::static_thread_pool pool(1);
+  auto sched = pool.get_scheduler();
+  exec::async_scope scope;
+  mpsc_buffer_queue<int> q(2);
+
+  scope.spawn(on(sched, coro_stuck_pop(q)));
+  std::this_thread::sleep_for(10ms);
+  scope.request_stop();
+  stdexec::sync_wait(scope.on_empty());
+}
+
+TEST_CASE("broadcast_queue: every subscriber sees every element") {
+  broadcast_queue<std::string> q(2);
+  q.push("nobody listens");
+
+  auto a = q.subscribe();
+  auto b = q.subscribe();
+  REQUIRE(q.subscriber_count() == 2);
+
+  q.push("one");
+  q.push("two");
+  std::error_code ec;
+  REQUIRE_FALSE(q.try_push("three", ec));
+  REQUIRE(ec == conqueue_errc::full);
+
+  REQUIRE(a.pop() == "one");
+  REQUIRE(a.pop() == "two");
+  REQUIRE_FALSE(a.try_pop(ec));
+  REQUIRE(ec == conqueue_errc::empty);
+
+  // A late subscriber only sees what is pushed after it joined.
+  REQUIRE(b.pop() == "one");
+  auto c = q.subscribe();
+  q.push("three");
+  REQUIRE(c.pop() == "three");
+  REQUIRE(b.pop() == "two");
+
+  b.unsubscribe();
+  REQUIRE_FALSE(b.pop(ec));
+  REQUIRE(ec == conqueue_errc::closed);
+
+  q.close();
+  REQUIRE(a.pop() == "three");
+  REQUIRE_THROWS_AS(a.pop(), conqueue_error);
+  REQUIRE_THROWS_AS(q.push("four"), conqueue_error);
+}
+
+TEST_CASE("broadcast_queue: lagging subscriber blocks the producer") {
+  broadcast_queue<int> q(1);
+  auto fast = q.subscribe();
+  auto slow = q.subscribe();
+  q.push(1);
+
+  atomic<bool> pushed{};
+  thread t([&q, &pushed] {
+    q.push(2);
+    pushed = true;
+  });
+  REQUIRE(fast.pop() == 1);
+  this_thread::sleep_for(10ms);
+  REQUIRE_FALSE(pushed);
+  REQUIRE(slow.pop() == 1);
+  REQUIRE(fast.pop() == 2);
+  REQUIRE(slow.pop() == 2);
+  t.join();
+}
+
+TEST_CASE("broadcast_queue: lagging subscriber is dropped") {
+  broadcast_queue<int> q(2, broadcast_lag_policy::drop_subscriber);
+  auto fast = q.subscribe();
+  auto slow = q.subscribe();
+  q.push(1);
+  q.push(2);
+  REQUIRE(fast.pop() == 1);
+
+  q.push(3);
+  std::error_code ec;
+  REQUIRE_FALSE(slow.pop(ec));
+  REQUIRE(ec == conqueue_errc::dropped);
+  REQUIRE(q.subscriber_count() == 1);
+  REQUIRE(fast.pop() == 2);
+  REQUIRE(fast.pop() == 3);
+}
+
+TEST_CASE("broadcast_queue: coro_pop") {
+  exec::static_thread_pool pool(1);
+  exec::async_scope scope;
+  broadcast_queue<int> q(2);
+  auto sub = q.subscribe();
+
+  scope.spawn(on(pool.get_scheduler(), coro_pop(sub)));
+
+  q.push(1);
+  q.push(2);
+  q.push(3);
+  q.push(4);
+
+  stdexec::sync_wait(scope.on_empty());
+}
+
+TEST_CASE("broadcast_queue: cancellation async_pop") {
+  exec::static_thread_pool pool(1);
+  auto sched = pool.get_scheduler();
+  exec::async_scope scope;
+  broadcast_queue<int> q(2);
+  auto sub = q.subscribe();
+
+  scope.spawn(on(sched, coro_stuck_pop(sub)));
+  std::this_thread::sleep_for(10ms);
+  scope.request_stop();
+  stdexec::sync_wait(scope.on_empty());
+}
+
+TEST_CASE("broadcast_queue: push while cancelling async_pop") {
+  exec::static_thread_pool pool(1);
+  auto sched = pool.get_scheduler();
+
+  // A push hands the element to all three waiters while the stop request
+  // cancels them, each of them must complete once.
+  for (int i = 0; i < 100; ++i) {
+    exec::async_scope scope;
+    broadcast_queue<int> q(2);
+    auto a = q.subscribe();
+    auto b = q.subscribe();
+    auto c = q.subscribe();
+
+    scope.spawn(on(sched, coro_stuck_pop(a)));
+    scope.spawn(on(sched, coro_stuck_pop(b)));
+    scope.spawn(on(sched, coro_stuck_pop(c)));
+    std::this_thread::sleep_for(1ms);
+    thread t([&scope] { scope.request_stop(); });
+    q.push(1);
+    t.join();
+    stdexec::sync_wait(scope.on_empty());
+  }
+}
+
+TEST_CASE("broadcast_queue: cancelling released poppers") {
+  broadcast_queue<int> q(2);
+  completion_counter a, b, c;
+  // The queue releases all three. Completing the first one cancels the
+  // second, which must then complete once, the way it was released.
+  a.on_first = [&] { b.stop.request_stop(); };
+
+  SECTION("released by a push") {
+    auto s1 = q.subscribe();
+    auto s2 = q.subscribe();
+    auto s3 = q.subscribe();
+    auto op1 = stdexec::connect(s1.async_pop(), counting_receiver{&a});
+    auto op2 = stdexec::connect(s2.async_pop(), counting_receiver{&b});
+    auto op3 = stdexec::connect(s3.async_pop(), counting_receiver{&c});
+    stdexec::start(op1);
+    stdexec::start(op2);
+    stdexec::start(op3);
+
+    q.push(1);
+    REQUIRE(a.total() == 1);
+    REQUIRE(b.total() == 1);
+    REQUIRE(b.values == 1);
+    REQUIRE(c.total() == 1);
+  }
+  SECTION("released by leaving") {
+    auto sub = q.subscribe();
+    auto op1 = stdexec::connect(sub.async_pop(), counting_receiver{&a});
+    auto op2 = stdexec::connect(sub.async_pop(), counting_receiver{&b});
+    auto op3 = stdexec::connect(sub.async_pop(), counting_receiver{&c});
+    stdexec::start(op1);
+    stdexec::start(op2);
+    stdexec::start(op3);
+
+    sub.unsubscribe();
+    REQUIRE(a.total() == 1);
+    REQUIRE(b.total() == 1);
+    REQUIRE(b.errors == 1);
+    REQUIRE(c.total() == 1);
+  }
+}
+
+TEST_CASE("broadcast_queue: async_push") {
+  broadcast_queue<int> q(1);
+  auto sub = q.subscribe();
+  completion_counter first, blocked, cancelled;
+  auto op1 = stdexec::connect(q.async_push(1), counting_receiver{&first});
+  stdexec::start(op1);
+  REQUIRE(first.values == 1);
+
+  // The subscriber is a full ring behind, the next pushes wait for it.
+  auto op2 = stdexec::connect(q.async_push(2), counting_receiver{&blocked});
+  auto op3 = stdexec::connect(q.async_push(3), counting_receiver{&cancelled});
+  stdexec::start(op2);
+  stdexec::start(op3);
+  REQUIRE(blocked.total() == 0);
+  REQUIRE(cancelled.total() == 0);
+  cancelled.stop.request_stop();
+  REQUIRE(cancelled.stopped == 1);
+
+  REQUIRE(sub.pop() == 1);
+  REQUIRE(blocked.values == 1);
+  REQUIRE(sub.pop() == 2);
+  std::error_code ec;
+  REQUIRE_FALSE(sub.try_pop(ec));
+
+  q.close();
+  completion_counter closed;
+  auto op4 = stdexec::connect(q.async_push(4), counting_receiver{&closed});
+  stdexec::start(op4);
+  REQUIRE(closed.errors == 1);
+}
+
+namespace {
+
+struct copy_counted {
+  static inline int copies = 0;
+  int value;
+
+  explicit copy_counted(int value) : value(value) {}
+  copy_counted(const copy_counted& other) : value(other.value) { ++copies; }
+  copy_counted(copy_counted&& other) noexcept
+      : value(std::exchange(other.value, -1)) {}
+  copy_counted& operator=(const copy_counted&) = default;
+  copy_counted& operator=(copy_counted&& other) noexcept {
+    value = std::exchange(other.value, -1);
+    return *this;
+  }
+};
+
+} // namespace
+
+TEST_CASE("broadcast_queue: readers copy, the last one moves") {
+  broadcast_queue<copy_counted> q(1);
+  auto a = q.subscribe();
+  auto b = q.subscribe();
+  auto c = q.subscribe();
+  copy_counted::copies = 0;
+  q.push(copy_counted(1));
+  REQUIRE(copy_counted::copies == 0);
+
+  REQUIRE(a.pop().value == 1);
+  REQUIRE(b.pop().value == 1);
+  REQUIRE(copy_counted::copies == 2);
+  REQUIRE(c.pop().value == 1);
+  REQUIRE(copy_counted::copies == 2);
+
+  // A push that fails leaves the element with the caller.
+  q.push(copy_counted(2));
+  copy_counted x(3);
+  std::error_code ec;
+  REQUIRE_FALSE(q.try_push(std::move(x), ec));
+  REQUIRE(ec == conqueue_errc::full);
+  REQUIRE(x.value == 3);
+}
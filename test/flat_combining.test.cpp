@@ -0,0 +1,64 @@
+#include "std/experimental/__detail/flat_combining.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace std::experimental::__detail;
+
+TEST_CASE("flat_combining: collect takes every published request") {
+  publication_list<combining_request> list;
+  combining_request a, b;
+  REQUIRE(list.publish(&a));
+
+  std::vector<combining_request*> seen;
+  REQUIRE(list.collect([&](auto* r) { seen.push_back(r); }) == 1);
+  REQUIRE(seen == std::vector<combining_request*>{&a});
+  REQUIRE(list.collect([&](auto* r) { seen.push_back(r); }) == 0);
+
+  REQUIRE(list.publish(&b));
+  REQUIRE(list.collect([&](auto* r) { seen.push_back(r); }) == 1);
+  REQUIRE(seen.back() == &b);
+}
+
+TEST_CASE("flat_combining: every thread gets a record of its own") {
+  // Many more publishers than cores, all with a request pending at the same
+  // time. None of them has to fall back to the regular path.
+  constexpr int thread_count = 100;
+  publication_list<combining_request> list;
+  std::vector<combining_request> requests(thread_count);
+  std::atomic<int> published{};
+  std::atomic<int> declined{};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < thread_count; ++i)
+    threads.emplace_back([&, i] {
+      if (list.publish(&requests[i]))
+        ++published;
+      else
+        ++declined;
+      requests[i].status.wait(combining_request::pending);
+    });
+
+  while (published + declined < thread_count)
+    std::this_thread::yield();
+  REQUIRE(declined == 0);
+
+  int collected = 0;
+  list.collect([&](combining_request* r) {
+    ++collected;
+    r->finish(combining_request::done);
+    r->status.notify_one();
+  });
+  REQUIRE(collected == thread_count);
+  for (auto& t : threads)
+    t.join();
+
+  // The records of the threads that are gone are dropped, and a new thread
+  // gets a fresh one.
+  REQUIRE(list.collect([](auto*) {}) == 0);
+  bool republished = false;
+  std::thread([&] { republished = list.publish(&requests[0]); }).join();
+  REQUIRE(republished);
+  REQUIRE(list.collect([](auto*) {}) == 1);
+}
@@ -7,6 +7,7 @@ struct Item {
   int val{};
   Item* next{};
   Item* prev{};
+  Item* next_released{};
 };
 
 void test_invariant(intrusive_list<&Item::next, &Item::prev>& list) {
@@ -200,3 +201,52 @@ TEST_CASE("push and pop_front last") {
   REQUIRE(list.empty());
   test_invariant(list);
 }
+
+TEST_CASE("intrusive_list: walk from front to back") {
+  intrusive_list<&Item::next, &Item::prev> list;
+  Item a{1}, b{2}, c{3};
+  list.push_back(&a);
+  list.push_back(&b);
+  list.push_back(&c);
+
+  int sum = 0;
+  for (auto* item = list.front(); item; item = list.next(item))
+    sum = sum * 10 + item->val;
+  REQUIRE(sum == 123);
+}
+
+TEST_CASE("intrusive_list: insert after and walk back") {
+  intrusive_list<&Item::next, &Item::prev> list;
+  Item a{1}, b{2}, c{3};
+  list.push_back(&a);
+  list.insert_after(&a, &c);
+  list.insert_after(&a, &b);
+  REQUIRE(list.back() == &c);
+  test_invariant(list);
+
+  int sum = 0;
+  for (auto* item = list.back(); item; item = list.prev(item))
+    sum = sum * 10 + item->val;
+  REQUIRE(sum == 321);
+}
+
+TEST_CASE("intrusive_slist: released items look removed") {
+  intrusive_list<&Item::next, &Item::prev> list;
+  intrusive_slist<&Item::next_released> released;
+  Item a{1}, b{2}, c{3};
+  list.push_back(&a);
+  list.push_back(&b);
+  list.push_back(&c);
+
+  list.remove(&a);
+  released.push_back(&a);
+  released.push_back(list.try_pop_front());
+  REQUIRE_FALSE(list.try_remove(&a));
+  REQUIRE_FALSE(list.try_remove(&b));
+  REQUIRE(list.try_remove(&c));
+
+  REQUIRE(released.try_pop_front() == &a);
+  REQUIRE(released.try_pop_front() == &b);
+  REQUIRE(released.try_pop_front() == nullptr);
+  REQUIRE(released.empty());
+}
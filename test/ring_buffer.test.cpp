@@ -93,4 +93,19 @@ TEST_CASE("ring_buffer larger capacity") {
     REQUIRE(rb.pop_front().val == i);
     REQUIRE(rb.pop_front().val == i + 1);
   }
-}
\ No newline at end of file
+}
+
+TEST_CASE("ring_buffer: indexing from the front") {
+  ring_buffer<Item> rb{3};
+  rb.push_back(Item{1});
+  rb.push_back(Item{2});
+  rb.pop_front();
+  rb.push_back(Item{3});
+  rb.push_back(Item{4});
+  REQUIRE(rb[0].val == 2);
+  REQUIRE(rb[1].val == 3);
+  REQUIRE(rb[2].val == 4);
+  rb[1].val = 5;
+  rb.pop_front();
+  REQUIRE(rb[0].val == 5);
+}
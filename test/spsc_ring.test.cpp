@@ -0,0 +1,61 @@
+#include "std/experimental/__detail/spsc_ring.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+#include <memory>
+#include <thread>
+
+using namespace std::experimental::__detail;
+
+TEST_CASE("spsc_ring: push and pop") {
+  spsc_ring<int> ring(2);
+  REQUIRE(ring.capacity() == 2);
+  REQUIRE(ring.empty());
+  REQUIRE_FALSE(ring.try_pop());
+
+  REQUIRE(ring.try_push(1));
+  REQUIRE(ring.try_push(2));
+  REQUIRE(ring.full());
+  REQUIRE_FALSE(ring.try_push(3));
+
+  REQUIRE(ring.try_pop() == 1);
+  REQUIRE(ring.try_push(3));
+  REQUIRE(ring.try_pop() == 2);
+  REQUIRE(ring.try_pop() == 3);
+  REQUIRE(ring.empty());
+}
+
+TEST_CASE("spsc_ring: a failed push leaves the value alone") {
+  spsc_ring<std::unique_ptr<int>> ring(1);
+  REQUIRE(ring.try_push(std::make_unique<int>(1)));
+  auto value = std::make_unique<int>(2);
+  REQUIRE_FALSE(ring.try_push(std::move(value)));
+  REQUIRE(value);
+  REQUIRE(**ring.try_pop() == 1);
+}
+
+TEST_CASE("spsc_ring: destroys what is left") {
+  auto value = std::make_shared<int>(1);
+  {
+    spsc_ring<std::shared_ptr<int>> ring(4);
+    ring.try_push(value);
+    ring.try_push(value);
+    REQUIRE(value.use_count() == 3);
+  }
+  REQUIRE(value.use_count() == 1);
+}
+
+TEST_CASE("spsc_ring: producer and consumer threads") {
+  constexpr int count = 100000;
+  spsc_ring<int> ring(16);
+  std::thread producer([&ring] {
+    for (int i = 0; i < count;)
+      if (ring.try_push(i))
+        ++i;
+  });
+
+  for (int expected = 0; expected < count;)
+    if (auto value = ring.try_pop())
+      REQUIRE(*value == expected++);
+
+  producer.join();
+}